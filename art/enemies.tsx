@@ -3,97 +3,161 @@
  <grid orientation="orthogonal" width="1" height="1"/>
  <tile id="0">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="257"/>
+   <property name="pathLength" type="int" value="3"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="128" height="384" source="enemy_bottom_to_top_3.png"/>
  </tile>
  <tile id="1">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="258"/>
+   <property name="pathLength" type="int" value="4"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="128" height="512" source="enemy_bottom_to_top_4.png"/>
  </tile>
  <tile id="2">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="259"/>
+   <property name="pathLength" type="int" value="6"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="128" height="768" source="enemy_bottom_to_top_6.png"/>
  </tile>
  <tile id="3">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="260"/>
+   <property name="pathLength" type="int" value="12"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="128" height="1536" source="enemy_bottom_to_top_12.png"/>
  </tile>
  <tile id="4">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="261"/>
+   <property name="pathLength" type="int" value="3"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="384" height="128" source="enemy_left_to_right_3.png"/>
  </tile>
  <tile id="5">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="262"/>
+   <property name="pathLength" type="int" value="4"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="512" height="128" source="enemy_left_to_right_4.png"/>
  </tile>
  <tile id="6">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="263"/>
+   <property name="pathLength" type="int" value="6"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="768" height="128" source="enemy_left_to_right_6.png"/>
  </tile>
  <tile id="7">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="264"/>
+   <property name="pathLength" type="int" value="12"/>
+   <property name="startsAtEnd" type="bool" value="false"/>
   </properties>
   <image width="1536" height="128" source="enemy_left_to_right_12.png"/>
  </tile>
  <tile id="8">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="265"/>
+   <property name="pathLength" type="int" value="3"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="384" height="128" source="enemy_right_to_left_3.png"/>
  </tile>
  <tile id="9">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="266"/>
+   <property name="pathLength" type="int" value="4"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="512" height="128" source="enemy_right_to_left_4.png"/>
  </tile>
  <tile id="10">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="267"/>
+   <property name="pathLength" type="int" value="6"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="768" height="128" source="enemy_right_to_left_6.png"/>
  </tile>
  <tile id="11">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="true"/>
    <property name="name" type="int" value="268"/>
+   <property name="pathLength" type="int" value="12"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="1536" height="128" source="enemy_right_to_left_12.png"/>
  </tile>
  <tile id="12">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="269"/>
+   <property name="pathLength" type="int" value="3"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="128" height="384" source="enemy_top_to_bottom_3.png"/>
  </tile>
  <tile id="13">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="270"/>
+   <property name="pathLength" type="int" value="4"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="128" height="512" source="enemy_top_to_bottom_4.png"/>
  </tile>
  <tile id="14">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="271"/>
+   <property name="pathLength" type="int" value="6"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="128" height="768" source="enemy_top_to_bottom_6.png"/>
  </tile>
  <tile id="15">
   <properties>
+   <property name="enemyBlueprint" type="bool" value="true"/>
+   <property name="horizontal" type="bool" value="false"/>
    <property name="name" type="int" value="272"/>
+   <property name="pathLength" type="int" value="12"/>
+   <property name="startsAtEnd" type="bool" value="true"/>
   </properties>
   <image width="128" height="1536" source="enemy_top_to_bottom_12.png"/>
  </tile>
@@ -1,4 +1,16 @@
 <?xml version="1.0" encoding="UTF-8"?>
 <tileset version="1.5" tiledversion="1.6.0" name="tiles" tilewidth="128" tileheight="128" tilecount="256" columns="16">
  <image source="../build/tiles.png" width="2048" height="2048"/>
+ <tile id="0">
+  <properties>
+   <property name="ground" type="bool" value="true"/>
+   <property name="impassable" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="1">
+  <properties>
+   <property name="ground" type="bool" value="true"/>
+   <property name="impassable" type="bool" value="true"/>
+  </properties>
+ </tile>
 </tileset>
@@ -0,0 +1,66 @@
+# Generates the tile property table included by level.hpp from the tile properties set in Tiled, so that tiles get new
+# properties without code changes. A tile is numbered by its id in the tileset, or by its "name" property when it has one.
+# Every bool property that is true sets the TileFlags_ flag of the same name; "pathLength" is an int property.
+#
+# cmake -D OUTPUT=<header> -D TILESETS=<tileset>[,<tileset>...] -P tileproperties.cmake
+
+string( REPLACE "," ";" TILESETS "${TILESETS}" )
+
+set( lastTile -1 )
+foreach( tileset IN LISTS TILESETS )
+	file( READ "${tileset}" xml )
+	string( REPLACE ";" "," xml "${xml}" )
+	string( REPLACE "<tile " ";<tile " blocks "${xml}" )
+
+	foreach( block IN LISTS blocks )
+		if( NOT block MATCHES "^<tile id=\"([0-9]+)\"" )
+			continue()
+		endif()
+		set( tile ${CMAKE_MATCH_1} )
+		if( block MATCHES "<property name=\"name\" type=\"int\" value=\"([0-9]+)\"" )
+			set( tile ${CMAKE_MATCH_1} )
+		endif()
+		if( DEFINED tile${tile}Flags )
+			message( FATAL_ERROR "Tile ${tile} has properties in more than one place" )
+		endif()
+
+		set( flags "" )
+		string( REGEX MATCHALL "<property name=\"[A-Za-z]+\" type=\"bool\" value=\"true\"" properties "${block}" )
+		foreach( property IN LISTS properties )
+			string( REGEX REPLACE "^<property name=\"([A-Za-z]+)\".*" "\\1" name "${property}" )
+			string( SUBSTRING "${name}" 0 1 first )
+			string( SUBSTRING "${name}" 1 -1 rest )
+			string( TOUPPER "${first}" first )
+			list( APPEND flags "TileFlags_${first}${rest}" )
+		endforeach()
+		if( NOT flags )
+			set( flags "TileFlags_None" )
+		endif()
+		string( REPLACE ";" " | " tile${tile}Flags "${flags}" )
+
+		set( tile${tile}PathLength 0 )
+		if( block MATCHES "<property name=\"pathLength\" type=\"int\" value=\"([0-9]+)\"" )
+			set( tile${tile}PathLength ${CMAKE_MATCH_1} )
+		endif()
+
+		if( tile GREATER lastTile )
+			set( lastTile ${tile} )
+		endif()
+	endforeach()
+endforeach()
+
+set( header "// Generated by cmake/tileproperties.cmake from the Tiled tilesets; edit the tile properties in Tiled instead\n" )
+string( APPEND header "#pragma once\n\n" )
+string( APPEND header "// Properties of every tile from Tiles::getEmpty() to the last one with properties\n" )
+string( APPEND header "static constexpr TileProperties tilePropertyTable[] =\n{\n" )
+string( APPEND header "\t{ TileFlags_None, 0 },\n" )
+foreach( tile RANGE 0 ${lastTile} )
+	if( DEFINED tile${tile}Flags )
+		string( APPEND header "\t{ ${tile${tile}Flags}, ${tile${tile}PathLength} },\n" )
+	else()
+		string( APPEND header "\t{ TileFlags_None, 0 },\n" )
+	endif()
+endforeach()
+string( APPEND header "};\n" )
+
+file( WRITE "${OUTPUT}" "${header}" )
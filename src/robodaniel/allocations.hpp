@@ -0,0 +1,180 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <array>
+
+// Counts heap allocations made through operator new, per frame and per named scope. Counting only happens in builds with
+// __TRACK_ALLOCATIONS, where exactly one translation unit defines ALLOCATION_TRACKER_IMPLEMENTATION before including this header.
+class AllocationTracker
+{
+public:
+	struct Counters
+	{
+		size_t allocations = 0;
+		size_t bytes = 0;
+	};
+
+	struct ScopeCounters
+	{
+		const char* name = nullptr;
+		Counters lastFrame;
+		Counters current;
+	};
+
+	static const int maxScopes = 32;
+
+	// Scopes are only tallied on the main thread
+	class Scope
+	{
+	public:
+		Scope( const char* _name ) : name( _name ), start( getThreadCounters() ) { }
+
+		~Scope()
+		{
+			const Counters& now = getThreadCounters();
+			ScopeCounters* scope = findScope( name );
+			if ( scope )
+			{
+				scope->current.allocations += now.allocations - start.allocations;
+				scope->current.bytes += now.bytes - start.bytes;
+			}
+		}
+
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+
+	private:
+		const char* name;
+		const Counters start;
+	};
+
+	static constexpr bool isEnabled()
+	{
+		return __TRACK_ALLOCATIONS;
+	}
+
+	// Must not allocate, as it runs inside operator new
+	static void recordAllocation( const size_t bytes )
+	{
+		Counters& counters = getThreadCounters();
+		++counters.allocations;
+		counters.bytes += bytes;
+	}
+
+	// Running totals of the calling thread
+	static Counters& getThreadCounters()
+	{
+		thread_local Counters counters;
+		return counters;
+	}
+
+	// Called once per frame on the main thread
+	static void endFrame()
+	{
+		State& state = getState();
+		const Counters& now = getThreadCounters();
+		state.lastFrame = Counters{ now.allocations - state.frameStart.allocations, now.bytes - state.frameStart.bytes };
+		state.frameStart = now;
+
+		for ( int i = 0; i < state.scopeCount; ++i )
+		{
+			state.scopes[ i ].lastFrame = state.scopes[ i ].current;
+			state.scopes[ i ].current = Counters();
+		}
+	}
+
+	// Main thread allocations of the previous frame
+	static const Counters& getLastFrame()
+	{
+		return getState().lastFrame;
+	}
+
+	static int getScopeCount()
+	{
+		return getState().scopeCount;
+	}
+
+	static const ScopeCounters& getScope( const int index )
+	{
+		return getState().scopes[ index ];
+	}
+
+private:
+	struct State
+	{
+		Counters frameStart;
+		Counters lastFrame;
+		std::array<ScopeCounters, maxScopes> scopes;
+		int scopeCount = 0;
+	};
+
+	static State& getState()
+	{
+		static State state;
+		return state;
+	}
+
+	// Scope names are string literals, so they are told apart by address
+	static ScopeCounters* findScope( const char* name )
+	{
+		State& state = getState();
+		for ( int i = 0; i < state.scopeCount; ++i )
+		{
+			if ( state.scopes[ i ].name == name )
+			{
+				return &state.scopes[ i ];
+			}
+		}
+
+		if ( state.scopeCount == maxScopes )
+		{
+			return nullptr;
+		}
+
+		ScopeCounters& scope = state.scopes[ state.scopeCount++ ];
+		scope.name = name;
+		return &scope;
+	}
+};
+
+#define ALLOCATION_CONCAT_INNER( a, b ) a##b
+#define ALLOCATION_CONCAT( a, b ) ALLOCATION_CONCAT_INNER( a, b )
+#define ALLOCATION_SCOPE( name ) AllocationTracker::Scope ALLOCATION_CONCAT( allocationScope, __LINE__ )( name )
+
+#if defined( ALLOCATION_TRACKER_IMPLEMENTATION ) && __TRACK_ALLOCATIONS
+void* operator new( std::size_t size )
+{
+	AllocationTracker::recordAllocation( size );
+	if ( void* pointer = std::malloc( size ? size : 1 ) )
+	{
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[]( std::size_t size )
+{
+	return operator new( size );
+}
+
+void operator delete( void* pointer ) noexcept
+{
+	std::free( pointer );
+}
+
+void operator delete[]( void* pointer ) noexcept
+{
+	std::free( pointer );
+}
+
+void operator delete( void* pointer, std::size_t ) noexcept
+{
+	std::free( pointer );
+}
+
+void operator delete[]( void* pointer, std::size_t ) noexcept
+{
+	std::free( pointer );
+}
+#endif
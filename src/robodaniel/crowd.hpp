@@ -0,0 +1,303 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <random>
+#include <algorithm>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <raylib.h>
+#include <raymath.h>
+#include <intmath.hpp>
+#include <level.hpp>
+#include <pathfinder.hpp>
+#include <profiler.hpp>
+#include <simulation.hpp>
+
+// Robots that walk with the hero's moves between a few shared targets. Robots heading to the same target share its flow field,
+// so choosing a move is a table lookup however many robots there are. Flow fields are computed by jobs started with the given
+// launch policy, on a copy of the level; until a target's new field is ready, its robots keep following the one they had.
+class Crowd
+{
+public:
+	struct Agent
+	{
+		// Cell the current move started from
+		int cell = 0;
+		uint16_t target = 0;
+		// FlowField::noMove while waiting for a target it can reach
+		uint8_t move = FlowField::noMove;
+		uint8_t length = 0;
+		// In steps along the current move
+		Fixed progress;
+	};
+
+	// A target moves elsewhere this often, which replaces its flow field
+	static const int ticksPerTargetMove = 5 * simulationTicksPerSecond;
+
+	Crowd( const Level& _level, const Pathfinder& _pathfinder, const Vector2Int& hero, const int agentCount, const int targetCount, const uint64_t seed, const std::launch _jobPolicy ) : level( _level ), pathfinder( _pathfinder ), random( seed ), jobPolicy( _jobPolicy )
+	{
+		PROFILE_SCOPE( "Crowd::Crowd" );
+
+		// Trajectories of each move cut short after each number of steps, smoothed like the hero's paths
+		for ( int moveIndex = 0; moveIndex < Pathfinder::getMoveCount(); ++moveIndex )
+		{
+			firstCurveOfMove.push_back( int( curves.size() ) );
+			const MoveDefinition& move = Pathfinder::getMove( moveIndex );
+			std::vector<Vector2Int> trajectory{ Vector2IntZero() };
+			for ( int step = 0; step < move.stepCount; ++step )
+			{
+				trajectory.push_back( move.steps[ step ] );
+				curves.push_back( Pathfinder::catmullClark( trajectory, 2, 0, move.flags ) );
+			}
+		}
+
+		// Targets and robots are placed on cells the hero can stand on and reach, so that they share one connected area
+		const std::vector<bool> reachable = pathfinder.findReachableCells( hero );
+		for ( int i = 0; i < reachable.size(); ++i )
+		{
+			const Vector2Int cell = Vector2IntFromIndex( i, level.getSize().x );
+			const Vector2Int below = cell + Vector2Int{ 0, 1 };
+			if ( reachable[ i ] && Vector2IntInBounds( below, level.getSize() ) && Tiles::isImpassable( level.getCellAt( below ) ) )
+			{
+				standingCells.push_back( cell );
+			}
+		}
+		if ( standingCells.empty() )
+		{
+			return;
+		}
+
+		for ( int i = 0; i < targetCount; ++i )
+		{
+			targets.push_back( getRandomStandingCell() );
+		}
+		targetFields.assign( targets.size(), nullptr );
+		updateFlowFields();
+
+		agents.resize( agentCount );
+		for ( int i = 0; i < agents.size(); ++i )
+		{
+			Agent& agent = agents[ i ];
+			agent.cell = Vector2IntToIndex( getRandomStandingCell(), level.getSize().x );
+			agent.target = uint16_t( i % targets.size() );
+		}
+	}
+
+	// Advances every robot by the given number of steps
+	void update( const Fixed& steps )
+	{
+		PROFILE_SCOPE( "Crowd::update" );
+
+		if ( targets.empty() )
+		{
+			return;
+		}
+
+		if ( ++ticks % ticksPerTargetMove == 0 )
+		{
+			moveTarget( int( random() % targets.size() ) );
+		}
+		updateFlowFields();
+
+		for ( Agent& agent : agents )
+		{
+			if ( agent.move == FlowField::noMove )
+			{
+				startNextMove( agent );
+				continue;
+			}
+
+			agent.progress += steps;
+			while ( agent.progress >= Fixed::fromInt( agent.length ) )
+			{
+				agent.progress -= Fixed::fromInt( agent.length );
+				const Vector2Int end = Vector2IntFromIndex( agent.cell, level.getSize().x ) + Pathfinder::getMove( agent.move ).steps[ agent.length - 1 ];
+				agent.cell = Vector2IntToIndex( end, level.getSize().x );
+				startNextMove( agent );
+				if ( agent.move == FlowField::noMove )
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	// Moves a target to another cell, dropping its flow field unless another target still uses it; its robots keep the field
+	// until the one of the new cell is ready
+	void moveTarget( const int targetIndex )
+	{
+		const Vector2Int previous = targets[ targetIndex ];
+		targets[ targetIndex ] = getRandomStandingCell();
+		if ( std::find( targets.begin(), targets.end(), previous ) == targets.end() )
+		{
+			flowFields.erase( CellKey( previous ) );
+		}
+	}
+
+	// Drops the flow fields that reach one of the given cells, for when the level changed, and the jobs started before. Robots
+	// keep following the dropped fields until they are computed again: a cell opened beside their area only hides a shortcut,
+	// and moves are measured again before being taken.
+	void invalidate( const std::unordered_set<CellKey>& changedCells )
+	{
+		const int width = level.getSize().x;
+		for ( auto it = flowFields.begin(); it != flowFields.end(); )
+		{
+			const std::vector<float>& distances = it->second->distances;
+			const bool reached = std::any_of( changedCells.begin(), changedCells.end(), [ &distances, width ]( const CellKey& cell ) { return distances[ cell.toIndex( width ) ] >= 0; } );
+			it = reached ? flowFields.erase( it ) : std::next( it );
+		}
+		++levelVersion;
+	}
+
+	const std::vector<Agent>& getAgents() const
+	{
+		return agents;
+	}
+
+	const std::vector<Vector2Int>& getTargets() const
+	{
+		return targets;
+	}
+
+	size_t getFlowFieldCount() const
+	{
+		return flowFields.size();
+	}
+
+	// Top-left corner of the robot, the given number of steps further along its move
+	Vector2 getAgentPosition( const Agent& agent, const float extraSteps ) const
+	{
+		const Vector2 cell = Vector2IntToFloat( Vector2IntFromIndex( agent.cell, level.getSize().x ) );
+		if ( agent.move == FlowField::noMove )
+		{
+			return cell;
+		}
+
+		const std::vector<PathPoint>& curve = curves[ firstCurveOfMove[ agent.move ] + agent.length - 1 ];
+		const float progress = std::min( agent.progress.toFloat() + extraSteps, curve.back().progress.toFloat() );
+		for ( int i = 1; i < curve.size(); ++i )
+		{
+			const float end = curve[ i ].progress.toFloat();
+			if ( progress <= end )
+			{
+				const float start = curve[ i - 1 ].progress.toFloat();
+				const float blend = end > start ? ( progress - start ) / ( end - start ) : 1;
+				return Vector2Add( cell, Vector2Lerp( Vector2FixedToFloat( curve[ i - 1 ].coords ), Vector2FixedToFloat( curve[ i ].coords ), blend ) );
+			}
+		}
+		return Vector2Add( cell, Vector2FixedToFloat( curve.back().coords ) );
+	}
+
+	unsigned int getAgentMoveFlags( const Agent& agent ) const
+	{
+		return agent.move == FlowField::noMove ? MoveFlags_None : Pathfinder::getMoveFlags( agent.move );
+	}
+
+private:
+	// A flow field being computed, on the level as it was at levelVersion
+	struct FlowFieldJob
+	{
+		std::future<std::shared_ptr<const FlowField>> result;
+		int levelVersion = 0;
+	};
+
+	const Level& level;
+	const Pathfinder& pathfinder;
+	std::mt19937_64 random;
+	const std::launch jobPolicy;
+	int ticks = 0;
+	// Counts level edits, so that fields computed on an older level are dropped
+	int levelVersion = 0;
+
+	std::vector<Agent> agents;
+	std::vector<Vector2Int> standingCells;
+	std::vector<Vector2Int> targets;
+	// Flow fields by target cell, and the field each target's robots follow, which lags behind while a new one is computed
+	std::unordered_map<CellKey, std::shared_ptr<const FlowField>> flowFields;
+	std::unordered_map<CellKey, FlowFieldJob> flowFieldJobs;
+	std::vector<std::shared_ptr<const FlowField>> targetFields;
+
+	std::vector<std::vector<PathPoint>> curves;
+	std::vector<int> firstCurveOfMove;
+
+	Vector2Int getRandomStandingCell()
+	{
+		return standingCells[ random() % standingCells.size() ];
+	}
+
+	// Keeps the fields that finished computing, starts computing the missing ones, and gives each target its field once ready
+	void updateFlowFields()
+	{
+		for ( auto it = flowFieldJobs.begin(); it != flowFieldJobs.end(); )
+		{
+			FlowFieldJob& job = it->second;
+			if ( job.result.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::timeout )
+			{
+				++it;
+				continue;
+			}
+
+			std::shared_ptr<const FlowField> field = job.result.get();
+			if ( job.levelVersion == levelVersion && std::find( targets.begin(), targets.end(), field->target ) != targets.end() )
+			{
+				flowFields[ it->first ] = std::move( field );
+			}
+			it = flowFieldJobs.erase( it );
+		}
+
+		for ( int i = 0; i < targets.size(); ++i )
+		{
+			const CellKey target( targets[ i ] );
+			const auto field = flowFields.find( target );
+			if ( field != flowFields.end() )
+			{
+				targetFields[ i ] = field->second;
+			} else if ( flowFieldJobs.count( target ) == 0 )
+			{
+				// The level keeps changing while the job runs, so the job searches a copy
+				const Vector2Int cell = targets[ i ];
+				FlowFieldJob& job = flowFieldJobs[ target ];
+				job.levelVersion = levelVersion;
+				job.result = std::async( jobPolicy, [ snapshot = level, cell ]()
+					{
+						return std::make_shared<const FlowField>( Pathfinder( snapshot ).computeFlowField( cell ) );
+					} );
+			}
+		}
+	}
+
+	// Picks the move toward the robot's target, switching to another target once there or when the target cannot be reached.
+	// Robots wait while their target has no field yet.
+	void startNextMove( Agent& agent )
+	{
+		agent.move = FlowField::noMove;
+
+		const Vector2Int cell = Vector2IntFromIndex( agent.cell, level.getSize().x );
+		const FlowField* field = targetFields[ agent.target ].get();
+		if ( field && ( cell == field->target || field->distances[ agent.cell ] < 0 ) )
+		{
+			agent.target = uint16_t( random() % targets.size() );
+			field = targetFields[ agent.target ].get();
+		}
+
+		const uint8_t move = field ? field->moves[ agent.cell ] : FlowField::noMove;
+		if ( move == FlowField::noMove )
+		{
+			agent.progress = Fixed();
+			return;
+		}
+
+		// The field may predate a level edit, so the move is measured again
+		const int length = pathfinder.getMoveLength( cell, move );
+		if ( length > 0 )
+		{
+			agent.move = move;
+			agent.length = uint8_t( length );
+		} else
+		{
+			agent.progress = Fixed();
+		}
+	}
+};
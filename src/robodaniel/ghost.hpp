@@ -0,0 +1,210 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <raylib.h>
+#include <raymath.h>
+#include <intmath.hpp>
+
+// Hero state sampled at a fixed rate, recorded during a run and played back as a ghost on later attempts
+namespace Ghost
+{
+	static const float ticksPerSecond = 30.0f;
+	// Positions are stored in 1/16 of a cell
+	static const float quantaPerCell = 16.0f;
+
+	// Frame flags hold the hero MoveFlags, plus whether the hero is following a path
+	static const unsigned int movingFlag = 0x80;
+
+	struct Frame
+	{
+		Vector2 position;
+		unsigned int flags;
+	};
+
+	// Encoded layout: start position as two little endian int32, then three bytes per tick (int8 delta x, int8 delta y, flags)
+	static const size_t headerSize = 8;
+	// Runs recorded with int16 start positions, which only fit levels up to 2047 cells; told apart by their length modulo 3
+	static const size_t legacyHeaderSize = 4;
+
+	class Recorder
+	{
+	public:
+		// Records one tick; the caller samples the simulation ticksPerSecond times per simulated second
+		void record( const Vector2Fixed& position, const unsigned int flags )
+		{
+			const int x = quantize( position.x );
+			const int y = quantize( position.y );
+
+			if ( data.empty() )
+			{
+				writeInt32( x );
+				writeInt32( y );
+				lastX = x;
+				lastY = y;
+			}
+
+			// Deltas too large for a byte are spread over the following ticks, as the encoder tracks the decoded position
+			const int dx = std::clamp( x - lastX, -127, 127 );
+			const int dy = std::clamp( y - lastY, -127, 127 );
+			data.push_back( char( int8_t( dx ) ) );
+			data.push_back( char( int8_t( dy ) ) );
+			data.push_back( char( uint8_t( flags ) ) );
+			lastX += dx;
+			lastY += dy;
+		}
+
+		// Makes recording allocation free for runs up to the given length
+		void reserve( const float seconds )
+		{
+			data.reserve( headerSize + 3 * size_t( seconds * ticksPerSecond + 1 ) );
+		}
+
+		const std::string& getData() const
+		{
+			return data;
+		}
+
+	private:
+		std::string data;
+		int lastX = 0;
+		int lastY = 0;
+
+		// Nearest quantum, in integer math so that recordings are identical on every platform
+		static int quantize( const Fixed& value )
+		{
+			const int64_t rawPerQuantum = Fixed::rawOne / quantaPerCell;
+			return int( ( value.raw + rawPerQuantum / 2 ) / rawPerQuantum );
+		}
+
+		void writeInt32( const int value )
+		{
+			for ( int shift = 0; shift < 32; shift += 8 )
+			{
+				data.push_back( char( ( uint32_t( value ) >> shift ) & 0xff ) );
+			}
+		}
+	};
+
+	// Decodes a whole run once, so that seeking by time is a direct index
+	class Playback
+	{
+	public:
+		Playback( const std::string& data )
+		{
+			const size_t size = data.size() % 3 == legacyHeaderSize % 3 ? legacyHeaderSize : headerSize;
+			if ( data.size() < size )
+			{
+				return;
+			}
+
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>( data.data() );
+			int x;
+			int y;
+			if ( size == legacyHeaderSize )
+			{
+				x = int16_t( bytes[ 0 ] | ( bytes[ 1 ] << 8 ) );
+				y = int16_t( bytes[ 2 ] | ( bytes[ 3 ] << 8 ) );
+			} else
+			{
+				x = readInt32( bytes );
+				y = readInt32( bytes + 4 );
+			}
+
+			frames.reserve( ( data.size() - size ) / 3 );
+			for ( size_t i = size; i + 2 < data.size(); i += 3 )
+			{
+				x += int8_t( bytes[ i ] );
+				y += int8_t( bytes[ i + 1 ] );
+				frames.push_back( Frame{ Vector2{ x / quantaPerCell, y / quantaPerCell }, bytes[ i + 2 ] } );
+			}
+		}
+
+		bool isEmpty() const
+		{
+			return frames.empty();
+		}
+
+		float getDuration() const
+		{
+			return frames.size() / ticksPerSecond;
+		}
+
+		// Interpolated position at the given time; the ghost rests on its last frame once the run is over
+		Frame getFrameAt( const float time ) const
+		{
+			const float tick = std::max( 0.0f, time * ticksPerSecond );
+			const size_t index = size_t( tick );
+			if ( index + 1 >= frames.size() )
+			{
+				return frames.back();
+			}
+
+			const Frame& current = frames[ index ];
+			const Frame& next = frames[ index + 1 ];
+			return Frame{ Vector2Lerp( current.position, next.position, tick - index ), current.flags };
+		}
+
+	private:
+		std::vector<Frame> frames;
+
+		static int readInt32( const unsigned char* bytes )
+		{
+			return int32_t( uint32_t( bytes[ 0 ] ) | ( uint32_t( bytes[ 1 ] ) << 8 ) | ( uint32_t( bytes[ 2 ] ) << 16 ) | ( uint32_t( bytes[ 3 ] ) << 24 ) );
+		}
+	};
+
+	// Base64, to keep the encoded run inside the JSON savegame
+	inline const char base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	inline std::string toBase64( const std::string& data )
+	{
+		std::string result;
+		result.reserve( ( data.size() + 2 ) / 3 * 4 );
+		for ( size_t i = 0; i < data.size(); i += 3 )
+		{
+			const size_t count = std::min<size_t>( 3, data.size() - i );
+			uint32_t block = 0;
+			for ( size_t j = 0; j < 3; ++j )
+			{
+				block = ( block << 8 ) | ( j < count ? uint8_t( data[ i + j ] ) : 0 );
+			}
+			for ( size_t j = 0; j < 4; ++j )
+			{
+				result.push_back( j <= count ? base64Alphabet[ ( block >> ( 18 - 6 * j ) ) & 0x3f ] : '=' );
+			}
+		}
+
+		return result;
+	}
+
+	inline std::string fromBase64( const std::string& text )
+	{
+		std::string result;
+		result.reserve( text.size() / 4 * 3 );
+
+		uint32_t block = 0;
+		int bits = 0;
+		for ( const char c : text )
+		{
+			const char* found = c ? std::strchr( base64Alphabet, c ) : nullptr;
+			if ( !found )
+			{
+				break;
+			}
+
+			block = ( block << 6 ) | uint32_t( found - base64Alphabet );
+			bits += 6;
+			if ( bits >= 8 )
+			{
+				bits -= 8;
+				result.push_back( char( ( block >> bits ) & 0xff ) );
+			}
+		}
+
+		return result;
+	}
+}
@@ -1,6 +1,11 @@
 #pragma once
 #include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
 #include <algorithm>
+#include <functional>
 
 struct Vector2Int
 {
@@ -15,131 +20,131 @@ struct Vector3Int
 	int z;
 };
 
-inline Vector2Int Vector2IntZero()
+constexpr inline Vector2Int Vector2IntZero()
 {
 	Vector2Int result = { 0, 0 };
 	return result;
 }
 
-inline Vector2Int Vector2IntOne()
+constexpr inline Vector2Int Vector2IntOne()
 {
 	Vector2Int result = { 1, 1 };
 	return result;
 }
 
-inline Vector2Int Vector2IntAdd( const Vector2Int& v1, const Vector2Int& v2 )
+constexpr inline Vector2Int Vector2IntAdd( const Vector2Int& v1, const Vector2Int& v2 )
 {
 	Vector2Int result = { v1.x + v2.x, v1.y + v2.y };
 	return result;
 }
 
-inline Vector2Int Vector2IntAddValue( const Vector2Int& v, const int add )
+constexpr inline Vector2Int Vector2IntAddValue( const Vector2Int& v, const int add )
 {
 	Vector2Int result = { v.x + add, v.y + add };
 	return result;
 }
 
-inline Vector2Int Vector2IntSubtract( const Vector2Int& v1, const Vector2Int& v2 )
+constexpr inline Vector2Int Vector2IntSubtract( const Vector2Int& v1, const Vector2Int& v2 )
 {
 	Vector2Int result = { v1.x - v2.x, v1.y - v2.y };
 	return result;
 }
 
-inline Vector2Int Vector2IntSubtractValue( const Vector2Int& v, const int sub )
+constexpr inline Vector2Int Vector2IntSubtractValue( const Vector2Int& v, const int sub )
 {
 	Vector2Int result = { v.x - sub, v.y - sub };
 	return result;
 }
 
-inline int Vector2IntLengthSqr( const Vector2Int& v )
+constexpr inline int Vector2IntLengthSqr( const Vector2Int& v )
 {
 	int result = ( v.x * v.x ) + ( v.y * v.y );
 	return result;
 }
 
-inline int Vector2IntDotProduct( const Vector2Int& v1, const Vector2Int& v2 )
+constexpr inline int Vector2IntDotProduct( const Vector2Int& v1, const Vector2Int& v2 )
 {
 	int result = ( v1.x * v2.x + v1.y * v2.y );
 	return result;
 }
 
-inline Vector2Int Vector2IntScale( const Vector2Int& v, const int scale )
+constexpr inline Vector2Int Vector2IntScale( const Vector2Int& v, const int scale )
 {
 	Vector2Int result = { v.x * scale, v.y * scale };
 	return result;
 }
 
-inline Vector2Int Vector2IntMultiply( const Vector2Int& v1, const Vector2Int& v2 )
+constexpr inline Vector2Int Vector2IntMultiply( const Vector2Int& v1, const Vector2Int& v2 )
 {
 	Vector2Int result = { v1.x * v2.x, v1.y * v2.y };
 	return result;
 }
 
-inline Vector2Int Vector2IntNegate( const Vector2Int& v )
+constexpr inline Vector2Int Vector2IntNegate( const Vector2Int& v )
 {
 	Vector2Int result = { -v.x, -v.y };
 	return result;
 }
 
-inline bool Vector2IntEqual( const Vector2Int& v1, const Vector2Int& v2 )
+constexpr inline bool Vector2IntEqual( const Vector2Int& v1, const Vector2Int& v2 )
 {
 	return v1.x == v2.x && v1.y == v2.y;
 }
 
-inline Vector2 Vector2IntToFloat( const Vector2Int& v )
+constexpr inline Vector2 Vector2IntToFloat( const Vector2Int& v )
 {
 	return Vector2{ float( v.x ), float( v.y ) };
 }
 
-inline Vector3Int Vector3IntZero()
+constexpr inline Vector3Int Vector3IntZero()
 {
 	Vector3Int result = { 0, 0, 0 };
 	return result;
 }
 
-inline Vector3Int Vector3IntOne()
+constexpr inline Vector3Int Vector3IntOne()
 {
 	Vector3Int result = { 1, 1, 1 };
 	return result;
 }
 
-inline Vector3Int Vector3IntAdd( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline Vector3Int Vector3IntAdd( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	Vector3Int result = { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z };
 	return result;
 }
 
-inline Vector3Int Vector3IntAddValue( const Vector3Int& v, const int add )
+constexpr inline Vector3Int Vector3IntAddValue( const Vector3Int& v, const int add )
 {
 	Vector3Int result = { v.x + add, v.y + add, v.z + add };
 	return result;
 }
 
-inline Vector3Int Vector3IntSubtract( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline Vector3Int Vector3IntSubtract( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	Vector3Int result = { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z };
 	return result;
 }
 
-inline Vector3Int Vector3IntSubtractValue( const Vector3Int& v, const int sub )
+constexpr inline Vector3Int Vector3IntSubtractValue( const Vector3Int& v, const int sub )
 {
 	Vector3Int result = { v.x - sub, v.y - sub, v.z - sub };
 	return result;
 }
 
-inline Vector3Int Vector3IntScale( const Vector3Int& v, const int scalar )
+constexpr inline Vector3Int Vector3IntScale( const Vector3Int& v, const int scalar )
 {
 	Vector3Int result = { v.x * scalar, v.y * scalar, v.z * scalar };
 	return result;
 }
 
-inline Vector3Int Vector3IntMultiply( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline Vector3Int Vector3IntMultiply( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	Vector3Int result = { v1.x * v2.x, v1.y * v2.y, v1.z * v2.z };
 	return result;
 }
 
-inline Vector3Int Vector3IntCrossProduct( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline Vector3Int Vector3IntCrossProduct( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	Vector3Int result = { v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z, v1.x * v2.y - v1.y * v2.x };
 	return result;
@@ -170,31 +175,31 @@ inline Vector3Int Vector3IntPerpendicular( const Vector3Int& v )
 	return result;
 }
 
-inline int Vector3IntLengthSqr( const Vector3Int& v )
+constexpr inline int Vector3IntLengthSqr( const Vector3Int& v )
 {
 	int result = v.x * v.x + v.y * v.y + v.z * v.z;
 	return result;
 }
 
-inline int Vector3IntDotProduct( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline int Vector3IntDotProduct( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	int result = ( v1.x * v2.x + v1.y * v2.y + v1.z * v2.z );
 	return result;
 }
 
-inline Vector3Int Vector3IntNegate( const Vector3Int& v )
+constexpr inline Vector3Int Vector3IntNegate( const Vector3Int& v )
 {
 	Vector3Int result = { -v.x, -v.y, -v.z };
 	return result;
 }
 
-inline Vector3Int Vector3IntDivide( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline Vector3Int Vector3IntDivide( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	Vector3Int result = { v1.x / v2.x, v1.y / v2.y, v1.z / v2.z };
 	return result;
 }
 
-inline Vector3Int Vector3IntMin( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline Vector3Int Vector3IntMin( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	Vector3Int result = { 0 };
 
@@ -205,7 +210,7 @@ inline Vector3Int Vector3IntMin( const Vector3Int& v1, const Vector3Int& v2 )
 	return result;
 }
 
-inline Vector3Int Vector3IntMax( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline Vector3Int Vector3IntMax( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	Vector3Int result = { 0 };
 
@@ -216,12 +221,384 @@ inline Vector3Int Vector3IntMax( const Vector3Int& v1, const Vector3Int& v2 )
 	return result;
 }
 
-inline bool Vector3IntEqual( const Vector3Int& v1, const Vector3Int& v2 )
+constexpr inline bool Vector3IntEqual( const Vector3Int& v1, const Vector3Int& v2 )
 {
 	return v1.x == v2.x && v1.y == v2.y && v1.z == v2.z;
 }
 
-inline Vector3 Vector3IntToFloat( const Vector3Int& v )
+constexpr inline Vector3 Vector3IntToFloat( const Vector3Int& v )
 {
 	return Vector3{ float( v.x ), float( v.y ), float( v.z ) };
-}
\ No newline at end of file
+}
+
+constexpr inline Vector2Int operator+( const Vector2Int& v1, const Vector2Int& v2 )
+{
+	return Vector2IntAdd( v1, v2 );
+}
+
+constexpr inline Vector2Int operator-( const Vector2Int& v1, const Vector2Int& v2 )
+{
+	return Vector2IntSubtract( v1, v2 );
+}
+
+constexpr inline Vector2Int operator-( const Vector2Int& v )
+{
+	return Vector2IntNegate( v );
+}
+
+constexpr inline Vector2Int operator*( const Vector2Int& v, const int scale )
+{
+	return Vector2IntScale( v, scale );
+}
+
+constexpr inline Vector2Int& operator+=( Vector2Int& v1, const Vector2Int& v2 )
+{
+	v1 = Vector2IntAdd( v1, v2 );
+	return v1;
+}
+
+constexpr inline Vector2Int& operator-=( Vector2Int& v1, const Vector2Int& v2 )
+{
+	v1 = Vector2IntSubtract( v1, v2 );
+	return v1;
+}
+
+constexpr inline bool operator==( const Vector2Int& v1, const Vector2Int& v2 )
+{
+	return Vector2IntEqual( v1, v2 );
+}
+
+constexpr inline bool operator!=( const Vector2Int& v1, const Vector2Int& v2 )
+{
+	return !Vector2IntEqual( v1, v2 );
+}
+
+constexpr inline Vector3Int operator+( const Vector3Int& v1, const Vector3Int& v2 )
+{
+	return Vector3IntAdd( v1, v2 );
+}
+
+constexpr inline Vector3Int operator-( const Vector3Int& v1, const Vector3Int& v2 )
+{
+	return Vector3IntSubtract( v1, v2 );
+}
+
+constexpr inline Vector3Int operator-( const Vector3Int& v )
+{
+	return Vector3IntNegate( v );
+}
+
+constexpr inline Vector3Int operator*( const Vector3Int& v, const int scale )
+{
+	return Vector3IntScale( v, scale );
+}
+
+constexpr inline Vector3Int& operator+=( Vector3Int& v1, const Vector3Int& v2 )
+{
+	v1 = Vector3IntAdd( v1, v2 );
+	return v1;
+}
+
+constexpr inline Vector3Int& operator-=( Vector3Int& v1, const Vector3Int& v2 )
+{
+	v1 = Vector3IntSubtract( v1, v2 );
+	return v1;
+}
+
+constexpr inline bool operator==( const Vector3Int& v1, const Vector3Int& v2 )
+{
+	return Vector3IntEqual( v1, v2 );
+}
+
+constexpr inline bool operator!=( const Vector3Int& v1, const Vector3Int& v2 )
+{
+	return !Vector3IntEqual( v1, v2 );
+}
+
+// Index of a cell in a row by row grid of the given width
+constexpr inline int Vector2IntToIndex( const Vector2Int& v, const int width )
+{
+	return v.y * width + v.x;
+}
+
+constexpr inline Vector2Int Vector2IntFromIndex( const int index, const int width )
+{
+	Vector2Int result = { index % width, index / width };
+	return result;
+}
+
+// Whether the cell lies in a grid of the given size, max excluded
+constexpr inline bool Vector2IntInBounds( const Vector2Int& v, const Vector2Int& size )
+{
+	return v.x >= 0 && v.x < size.x && v.y >= 0 && v.y < size.y;
+}
+
+// A cell packed in 32 bits, 16 per coordinate, for use as a hash key; coordinates must fit in 0..65535
+struct CellKey
+{
+	uint32_t value = 0;
+
+	constexpr CellKey() = default;
+
+	constexpr explicit CellKey( const Vector2Int& v ) : value( uint32_t( v.x ) | ( uint32_t( v.y ) << 16 ) ) { }
+
+	constexpr static CellKey fromIndex( const int index, const int width )
+	{
+		return CellKey( Vector2IntFromIndex( index, width ) );
+	}
+
+	constexpr Vector2Int toVector() const
+	{
+		Vector2Int result = { int( value & 0xffff ), int( value >> 16 ) };
+		return result;
+	}
+
+	constexpr int toIndex( const int width ) const
+	{
+		return Vector2IntToIndex( toVector(), width );
+	}
+
+	constexpr bool operator==( const CellKey& other ) const
+	{
+		return value == other.value;
+	}
+
+	constexpr bool operator!=( const CellKey& other ) const
+	{
+		return value != other.value;
+	}
+};
+
+namespace std
+{
+	template<> struct hash<CellKey>
+	{
+		size_t operator()( const CellKey& key ) const noexcept
+		{
+			// Fibonacci hashing spreads neighbouring cells across buckets
+			return size_t( key.value * 0x9e3779b1u );
+		}
+	};
+}
+
+// Batch operations over arrays of vectors, written as plain loops over contiguous ints so that the compiler vectorizes them
+// for whatever SIMD the target has
+inline void Vector2IntAddBatch( const Vector2Int* v, const Vector2Int& add, Vector2Int* result, const size_t count )
+{
+	for ( size_t i = 0; i < count; ++i )
+	{
+		result[ i ].x = v[ i ].x + add.x;
+		result[ i ].y = v[ i ].y + add.y;
+	}
+}
+
+inline void Vector2IntEqualBatch( const Vector2Int* v, const Vector2Int& other, uint8_t* result, const size_t count )
+{
+	for ( size_t i = 0; i < count; ++i )
+	{
+		result[ i ] = uint8_t( ( v[ i ].x == other.x ) & ( v[ i ].y == other.y ) );
+	}
+}
+
+inline void Vector2IntInBoundsBatch( const Vector2Int* v, const Vector2Int& size, uint8_t* result, const size_t count )
+{
+	for ( size_t i = 0; i < count; ++i )
+	{
+		// Unsigned compares also reject negative coordinates
+		result[ i ] = uint8_t( ( uint32_t( v[ i ].x ) < uint32_t( size.x ) ) & ( uint32_t( v[ i ].y ) < uint32_t( size.y ) ) );
+	}
+}
+
+// Signed fixed point number with 16 fraction bits. The simulation uses it instead of float so that a run gives bit identical
+// results whatever the compiler, CPU or platform. The raw value has 64 bits so that path progress and distances that grow
+// with time, such as the ticks walked since a click, do not run out of integer bits
+struct Fixed
+{
+	static constexpr int fractionBits = 16;
+	static constexpr int64_t rawOne = int64_t( 1 ) << fractionBits;
+	// Largest integer part a value can hold
+	static constexpr int64_t maxInt = INT64_MAX >> fractionBits;
+
+	int64_t raw = 0;
+
+	constexpr static Fixed fromRaw( const int64_t raw )
+	{
+		Fixed result;
+		result.raw = raw;
+		return result;
+	}
+
+	constexpr static Fixed fromInt( const int64_t value )
+	{
+		assert( value >= -maxInt && value <= maxInt );
+		return fromRaw( value * rawOne );
+	}
+
+	// Rounds to the nearest raw value; meant for settings and constants, as a float value always converts the same way
+	static Fixed fromFloat( const float value )
+	{
+		return fromRaw( llroundf( value * rawOne ) );
+	}
+
+	constexpr float toFloat() const
+	{
+		return float( raw ) / rawOne;
+	}
+
+	// Largest integer not greater than the value
+	constexpr int floor() const
+	{
+		return int( raw >> fractionBits );
+	}
+};
+
+constexpr inline Fixed operator+( const Fixed& a, const Fixed& b )
+{
+	return Fixed::fromRaw( a.raw + b.raw );
+}
+
+constexpr inline Fixed operator-( const Fixed& a, const Fixed& b )
+{
+	return Fixed::fromRaw( a.raw - b.raw );
+}
+
+constexpr inline Fixed operator-( const Fixed& a )
+{
+	return Fixed::fromRaw( -a.raw );
+}
+
+// Products and quotients truncate the extra fraction bits. The raw product must fit in 64 bits, so products and dividends
+// stay below maxInt / rawOne, about two billion, which interpolation with a factor of at most 1 never comes close to
+constexpr inline Fixed operator*( const Fixed& a, const Fixed& b )
+{
+	return Fixed::fromRaw( ( a.raw * b.raw ) >> Fixed::fractionBits );
+}
+
+constexpr inline Fixed operator/( const Fixed& a, const Fixed& b )
+{
+	return Fixed::fromRaw( a.raw * Fixed::rawOne / b.raw );
+}
+
+constexpr inline Fixed operator*( const Fixed& a, const int scale )
+{
+	return Fixed::fromRaw( a.raw * scale );
+}
+
+constexpr inline Fixed operator/( const Fixed& a, const int divisor )
+{
+	return Fixed::fromRaw( a.raw / divisor );
+}
+
+constexpr inline Fixed operator%( const Fixed& a, const Fixed& b )
+{
+	return Fixed::fromRaw( a.raw % b.raw );
+}
+
+constexpr inline Fixed& operator+=( Fixed& a, const Fixed& b )
+{
+	a.raw += b.raw;
+	return a;
+}
+
+constexpr inline Fixed& operator-=( Fixed& a, const Fixed& b )
+{
+	a.raw -= b.raw;
+	return a;
+}
+
+constexpr inline bool operator==( const Fixed& a, const Fixed& b )
+{
+	return a.raw == b.raw;
+}
+
+constexpr inline bool operator!=( const Fixed& a, const Fixed& b )
+{
+	return a.raw != b.raw;
+}
+
+constexpr inline bool operator<( const Fixed& a, const Fixed& b )
+{
+	return a.raw < b.raw;
+}
+
+constexpr inline bool operator<=( const Fixed& a, const Fixed& b )
+{
+	return a.raw <= b.raw;
+}
+
+constexpr inline bool operator>( const Fixed& a, const Fixed& b )
+{
+	return a.raw > b.raw;
+}
+
+constexpr inline bool operator>=( const Fixed& a, const Fixed& b )
+{
+	return a.raw >= b.raw;
+}
+
+struct Vector2Fixed
+{
+	Fixed x;
+	Fixed y;
+};
+
+constexpr inline Vector2Fixed Vector2FixedFromInt( const Vector2Int& v )
+{
+	Vector2Fixed result = { Fixed::fromInt( v.x ), Fixed::fromInt( v.y ) };
+	return result;
+}
+
+constexpr inline Vector2 Vector2FixedToFloat( const Vector2Fixed& v )
+{
+	Vector2 result = { v.x.toFloat(), v.y.toFloat() };
+	return result;
+}
+
+constexpr inline Vector2Int Vector2FixedFloor( const Vector2Fixed& v )
+{
+	Vector2Int result = { v.x.floor(), v.y.floor() };
+	return result;
+}
+
+constexpr inline Vector2Fixed operator+( const Vector2Fixed& v1, const Vector2Fixed& v2 )
+{
+	Vector2Fixed result = { v1.x + v2.x, v1.y + v2.y };
+	return result;
+}
+
+constexpr inline Vector2Fixed operator-( const Vector2Fixed& v1, const Vector2Fixed& v2 )
+{
+	Vector2Fixed result = { v1.x - v2.x, v1.y - v2.y };
+	return result;
+}
+
+constexpr inline Vector2Fixed operator*( const Vector2Fixed& v, const Fixed& scale )
+{
+	Vector2Fixed result = { v.x * scale, v.y * scale };
+	return result;
+}
+
+constexpr inline bool operator==( const Vector2Fixed& v1, const Vector2Fixed& v2 )
+{
+	return v1.x == v2.x && v1.y == v2.y;
+}
+
+constexpr inline bool operator!=( const Vector2Fixed& v1, const Vector2Fixed& v2 )
+{
+	return !( v1 == v2 );
+}
+
+constexpr inline Vector2Fixed Vector2FixedLerp( const Vector2Fixed& v1, const Vector2Fixed& v2, const Fixed& amount )
+{
+	return v1 + ( v2 - v1 ) * amount;
+}
+
+// Exact comparison of the squared distance; the squares are only taken once both offsets are known to be within the distance,
+// so far apart points do not overflow
+constexpr inline bool Vector2FixedWithinDistance( const Vector2Fixed& v1, const Vector2Fixed& v2, const Fixed& distance )
+{
+	const int64_t dx = v1.x.raw - v2.x.raw;
+	const int64_t dy = v1.y.raw - v2.y.raw;
+	const int64_t limit = distance.raw;
+	return dx <= limit && dx >= -limit && dy <= limit && dy >= -limit && dx * dx + dy * dy <= limit * limit;
+}
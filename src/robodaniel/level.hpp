@@ -0,0 +1,486 @@
+#pragma once
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <cstdint>
+#include <iterator>
+#include <raylib.h>
+#include <intmath.hpp>
+
+class BaseException : public std::exception
+{
+public:
+	BaseException( const std::string& _message ) : message( _message ) { }
+
+	const char* what() const noexcept override { return message.c_str(); }
+
+protected:
+	const std::string message;
+};
+
+// Set by the tile properties of the same name in Tiled
+enum TileFlags
+{
+	TileFlags_None = 0x0,
+	TileFlags_Ground = 0x1,
+	TileFlags_Impassable = 0x2,
+	TileFlags_EnemyBlueprint = 0x4,
+	// Of enemy blueprints: the enemy walks right instead of up, and starts from the end of its path
+	TileFlags_Horizontal = 0x8,
+	TileFlags_StartsAtEnd = 0x10,
+};
+
+struct TileProperties
+{
+	uint8_t flags;
+	// Of enemy blueprints, in cells
+	uint8_t pathLength;
+};
+
+// Generated at build time from art/tiles.tsx and art/enemies.tsx by cmake/tileproperties.cmake
+#include <tileproperties.hpp>
+
+class Tiles
+{
+public:
+	const int tileSize;
+
+	static const int tilePadding = 2;
+	static const int minTileSize = 16;
+	// GL_MAX_TEXTURE_SIZE guaranteed by the GLES2 devices we ship to (raspberrypi32); no texture may be larger on any side
+	static const int maxTextureSize = 2048;
+
+	// The tile image decoded, scaled and padded for every level of detail. Building it needs no GPU, so it can run on a worker thread.
+	struct Atlases
+	{
+		int tileSize = 0;
+		Vector2Int tilesPerSide;
+		std::vector<Image> images;
+		std::vector<int> tileSizes;
+	};
+
+	static Atlases decodeAtlases( const std::string& path, const int tileSize )
+	{
+		Atlases atlases;
+		atlases.tileSize = tileSize;
+		Image image = LoadImage( path.c_str() );
+		atlases.tilesPerSide = Vector2Int{ image.width / tileSize, image.height / tileSize };
+
+		// One padded atlas per halving of the tile size, so that drawing small never samples many texels per pixel. The
+		// padding goes inside each cell, so an atlas is exactly as big as the tile image; levels that still exceed the
+		// texture size limit are skipped.
+		for ( int cellSize = tileSize; cellSize >= minTileSize; cellSize /= 2 )
+		{
+			if ( atlases.tilesPerSide.x * cellSize > maxTextureSize || atlases.tilesPerSide.y * cellSize > maxTextureSize )
+			{
+				TraceLog( LOG_WARNING, "TILES: Skipping %dx%d atlas, larger than %d", atlases.tilesPerSide.x * cellSize, atlases.tilesPerSide.y * cellSize, maxTextureSize );
+				continue;
+			}
+			atlases.images.push_back( createPaddedAtlas( image, atlases.tilesPerSide, tileSize, cellSize ) );
+			atlases.tileSizes.push_back( cellSize - 2 * tilePadding );
+		}
+
+		UnloadImage( image );
+		if ( atlases.images.empty() )
+		{
+			throw BaseException( "Tile atlas does not fit in a texture" );
+		}
+		return atlases;
+	}
+
+	// Uploads the decoded atlases, which must happen on the main thread, and frees their images but the smallest
+	Tiles( const Atlases& atlases ) : tileSize( atlases.tileSize ), tilesPerSide( atlases.tilesPerSide ), tileCount( atlases.tilesPerSide.x * atlases.tilesPerSide.y )
+	{
+		for ( int lod = 0; lod < atlases.images.size(); ++lod )
+		{
+			const int size = atlases.tileSizes[ lod ];
+			const int cellSize = size + 2 * tilePadding;
+			Texture texture = LoadTextureFromImage( atlases.images[ lod ] );
+			SetTextureFilter( texture, TEXTURE_FILTER_BILINEAR );
+			if ( lod + 1 == atlases.images.size() )
+			{
+				smallestAtlas = atlases.images[ lod ];
+			} else
+			{
+				UnloadImage( atlases.images[ lod ] );
+			}
+
+			textures.push_back( texture );
+			lodTileSizes.push_back( size );
+
+			tileRectangles.resize( ( lod + 1 ) * tileCount );
+			for ( int tile = 0; tile < tileCount; ++tile )
+			{
+				tileRectangles[ lod * tileCount + tile ] = Rectangle{ float( ( tile % tilesPerSide.x ) * cellSize + tilePadding ), float( ( tile / tilesPerSide.x ) * cellSize + tilePadding ), float( size ), float( size ) };
+			}
+		}
+	}
+
+	~Tiles()
+	{
+		for ( const Texture& texture : textures )
+		{
+			UnloadTexture( texture );
+		}
+		UnloadImage( smallestAtlas );
+	}
+
+	Tiles( const Tiles& ) = delete;
+	Tiles& operator=( const Tiles& ) = delete;
+
+	// Returns the smallest atlas whose tiles are at least as big as the given on-screen size
+	int getLevelOfDetail( const float pixelsPerTile ) const
+	{
+		int lod = 0;
+		while ( lod + 1 < lodTileSizes.size() && lodTileSizes[ lod + 1 ] >= pixelsPerTile )
+		{
+			++lod;
+		}
+		return lod;
+	}
+
+	const Texture& getTexture( const int lod = 0 ) const
+	{
+		return textures.at( lod );
+	}
+
+	const Rectangle& getRectangleForTile( const int tile, const int lod = 0 ) const
+	{
+		return tileRectangles.at( lod * tileCount + tile );
+	}
+
+	int getTileCount() const
+	{
+		return tileCount;
+	}
+
+	// A tile scaled to the given size on the CPU, from the smallest atlas, which is kept in memory for this; safe on any thread
+	Image createTileImage( const int tile, const int size ) const
+	{
+		Image image = ImageFromImage( smallestAtlas, getRectangleForTile( tile, int( textures.size() ) - 1 ) );
+		if ( image.width != size || image.height != size )
+		{
+			ImageResize( &image, size, size );
+		}
+		return image;
+	}
+
+	static int getEmpty()
+	{
+		return -1;
+	}
+
+	static bool isGround( const int tile )
+	{
+		return getProperties( tile ).flags & TileFlags_Ground;
+	}
+
+	static bool isImpassable( const int tile )
+	{
+		return getProperties( tile ).flags & TileFlags_Impassable;
+	}
+
+	static int getHero()
+	{
+		return 32;
+	}
+
+	static const std::vector<int>& getHeroIdleAnimation()
+	{
+		static const std::vector<int> animation{ 32, 33, 34, 35, 36, 37, 38, 39, 40, 41 };
+		return animation;
+	}
+
+	static const std::vector<int>& getHeroIdleMirroredAnimation()
+	{
+		static const std::vector<int> animation{ 42, 43, 44, 45, 46, 47, 48, 49, 50, 51 };
+		return animation;
+	}
+
+	static const std::vector<int>& getHeroJumpAnimation()
+	{
+		static const std::vector<int> animation{ 52, 53, 54, 55, 56, 57, 58, 59, 60, 61 };
+		return animation;
+	}
+
+	static const std::vector<int>& getHeroJumpMirroredAnimation()
+	{
+		static const std::vector<int> animation{ 62, 63, 64, 65, 66, 67, 68, 69, 70, 71 };
+		return animation;
+	}
+
+	static const std::vector<int>& getHeroRunAnimation()
+	{
+		static const std::vector<int> animation{ 72, 73, 74, 75, 76, 77, 78, 79 };
+		return animation;
+	}
+
+	static const std::vector<int>& getHeroRunMirroredAnimation()
+	{
+		static const std::vector<int> animation{ 80, 81, 82, 83, 84, 85, 86, 87 };
+		return animation;
+	}
+
+	static int getCoin()
+	{
+		return 2;
+	}
+
+	static int getClosedExit()
+	{
+		return 3;
+	}
+
+	static int getOpenExit()
+	{
+		return 4;
+	}
+
+	static int getEnemy()
+	{
+		return 5;
+	}
+
+	static bool isEnemyBlueprint( const int tile )
+	{
+		return getProperties( tile ).flags & TileFlags_EnemyBlueprint;
+	}
+
+	// Everything the game knows about a tile besides its image, in one load
+	static TileProperties getProperties( const int tile )
+	{
+		const unsigned int index = unsigned( tile - getEmpty() );
+		return index < std::size( tilePropertyTable ) ? tilePropertyTable[ index ] : TileProperties{ TileFlags_None, 0 };
+	}
+
+private:
+	Vector2Int tilesPerSide;
+	int tileCount;
+	std::vector<Texture> textures;
+	std::vector<int> lodTileSizes;
+	std::vector<Rectangle> tileRectangles;
+	Image smallestAtlas{};
+
+	// Lays out cells of cellSize pixels, each holding the tile shrunk by the padding and its edges repeated into the padding, so that filtering never bleeds across tiles
+	static Image createPaddedAtlas( const Image& image, const Vector2Int& tilesPerSide, const int tileSize, const int cellSize )
+	{
+		const int tileCount = tilesPerSide.x * tilesPerSide.y;
+		const int size = cellSize - 2 * tilePadding;
+		Image atlas = GenImageColor( tilesPerSide.x * cellSize, tilesPerSide.y * cellSize, BLANK );
+
+		for ( int tile = 0; tile < tileCount; ++tile )
+		{
+			Image tileImage = ImageFromImage( image, Rectangle{ float( ( tile % tilesPerSide.x ) * tileSize ), float( ( tile / tilesPerSide.x ) * tileSize ), float( tileSize ), float( tileSize ) } );
+			if ( size != tileSize )
+			{
+				ImageResize( &tileImage, size, size );
+			}
+
+			const float x = float( ( tile % tilesPerSide.x ) * cellSize + tilePadding );
+			const float y = float( ( tile / tilesPerSide.x ) * cellSize + tilePadding );
+			const float last = float( size - 1 );
+			const float padding = float( tilePadding );
+			const float fullSize = float( size );
+
+			ImageDraw( &atlas, tileImage, Rectangle{ 0, 0, fullSize, fullSize }, Rectangle{ x, y, fullSize, fullSize }, WHITE );
+
+			// Edges
+			ImageDraw( &atlas, tileImage, Rectangle{ 0, 0, 1, fullSize }, Rectangle{ x - padding, y, padding, fullSize }, WHITE );
+			ImageDraw( &atlas, tileImage, Rectangle{ last, 0, 1, fullSize }, Rectangle{ x + fullSize, y, padding, fullSize }, WHITE );
+			ImageDraw( &atlas, tileImage, Rectangle{ 0, 0, fullSize, 1 }, Rectangle{ x, y - padding, fullSize, padding }, WHITE );
+			ImageDraw( &atlas, tileImage, Rectangle{ 0, last, fullSize, 1 }, Rectangle{ x, y + fullSize, fullSize, padding }, WHITE );
+
+			// Corners
+			ImageDraw( &atlas, tileImage, Rectangle{ 0, 0, 1, 1 }, Rectangle{ x - padding, y - padding, padding, padding }, WHITE );
+			ImageDraw( &atlas, tileImage, Rectangle{ last, 0, 1, 1 }, Rectangle{ x + fullSize, y - padding, padding, padding }, WHITE );
+			ImageDraw( &atlas, tileImage, Rectangle{ 0, last, 1, 1 }, Rectangle{ x - padding, y + fullSize, padding, padding }, WHITE );
+			ImageDraw( &atlas, tileImage, Rectangle{ last, last, 1, 1 }, Rectangle{ x + fullSize, y + fullSize, padding, padding }, WHITE );
+
+			UnloadImage( tileImage );
+		}
+
+		return atlas;
+	}
+};
+
+class Level
+{
+public:
+	Level( const std::filesystem::path& path )
+	{
+		parse( path, nullptr, nullptr );
+	}
+
+	// Parses a new version of a level and lists, in the same pass, the cells that differ from the previous version; the list
+	// is left empty if the size changed
+	Level( const std::filesystem::path& path, const Level& previous, std::vector<Vector2Int>& differences )
+	{
+		parse( path, &previous, &differences );
+	}
+
+	Level( const Vector2Int& _size, std::vector<int> _cells ) : size( _size ), cells( std::move( _cells ) )
+	{
+		if ( size.x <= 0 || size.y <= 0 || cells.size() != size.x * size.y )
+		{
+			throw BaseException( "Invalid level size" );
+		}
+	}
+
+	void save( const std::filesystem::path& path ) const
+	{
+		std::ofstream stream( path );
+		for ( int i = 0; i < size.y; ++i )
+		{
+			for ( int j = 0; j < size.x; ++j )
+			{
+				if ( j > 0 )
+				{
+					stream << ',';
+				}
+				stream << cells[ i * size.x + j ];
+			}
+			stream << '\n';
+		}
+
+		if ( !stream )
+		{
+			throw BaseException( "Cannot write level " + path.string() );
+		}
+	}
+
+	const Vector2Int getSize() const
+	{
+		return size;
+	}
+
+	int getCellAt( const Vector2Int& coords ) const
+	{
+		return cells.at( Vector2IntToIndex( coords, size.x ) );
+	}
+
+	void setCellAt( const Vector2Int& coords, const int tile )
+	{
+		if ( !Vector2IntInBounds( coords, size ) )
+		{
+			throw BaseException( "Coords out of bounds" );
+		}
+
+		cells.at( Vector2IntToIndex( coords, size.x ) ) = tile;
+		changedCells.push_back( coords );
+	}
+
+	// Lets the given number of further setCellAt calls run without allocating
+	void reserveChangedCells( const size_t count )
+	{
+		changedCells.reserve( changedCells.size() + count );
+	}
+
+	// Cells modified through setCellAt since the last clearChangedCells, in order
+	const std::vector<Vector2Int>& getChangedCells() const
+	{
+		return changedCells;
+	}
+
+	// Called by the renderer once it has drawn the changes; keeps the capacity, so that setCellAt does not allocate again
+	void clearChangedCells()
+	{
+		changedCells.clear();
+	}
+
+	// Empties the cells holding a tile that is neither in the atlas nor an enemy blueprint, so that a bad id in a level file
+	// cannot reach the renderer; returns how many were replaced
+	int replaceUnknownTiles( const int tileCount )
+	{
+		int replaced = 0;
+		for ( int& cell : cells )
+		{
+			if ( cell != Tiles::getEmpty() && !Tiles::isEnemyBlueprint( cell ) && ( cell < 0 || cell >= tileCount ) )
+			{
+				cell = Tiles::getEmpty();
+				++replaced;
+			}
+		}
+		return replaced;
+	}
+
+	Vector2Int findFirstCell( const int tile ) const
+	{
+		for ( int i = 0; i < size.y; ++i )
+		{
+			for ( int j = 0; j < size.x; ++j )
+			{
+				const Vector2Int coords{ j, i };
+				if ( getCellAt( coords ) == tile )
+				{
+					return coords;
+				}
+			}
+		}
+
+		return Vector2Int{ -1, -1 };
+	}
+
+	std::vector<Vector2Int> findAllCells( const int tile ) const
+	{
+		std::vector<Vector2Int> result;
+
+		for ( int i = 0; i < size.y; ++i )
+		{
+			for ( int j = 0; j < size.x; ++j )
+			{
+				const Vector2Int coords{ j, i };
+				if ( getCellAt( coords ) == tile )
+				{
+					result.push_back( coords );
+				}
+			}
+		}
+
+		return result;
+	}
+
+private:
+	Vector2Int size;
+	std::vector<int> cells;
+	std::vector<Vector2Int> changedCells;
+
+	void parse( const std::filesystem::path& path, const Level* previous, std::vector<Vector2Int>* differences )
+	{
+		std::ifstream stream( path );
+		int rows = 0;
+		std::string line;
+		while ( std::getline( stream, line ) )
+		{
+			++rows;
+
+			std::stringstream lineStream( line );
+			std::string svalue;
+
+			while ( std::getline( lineStream, svalue, ',' ) )
+			{
+				const int value = std::stoi( svalue );
+				const int index = int( cells.size() );
+				if ( previous && index < previous->cells.size() && previous->cells[ index ] != value )
+				{
+					differences->push_back( Vector2IntFromIndex( index, previous->size.x ) );
+				}
+				cells.push_back( value );
+			}
+		}
+
+		if ( rows == 0 || cells.empty() )
+		{
+			throw BaseException( "Level is empty" );
+		}
+
+		size.y = rows;
+		size.x = cells.size() / rows;
+
+		if ( previous && !Vector2IntEqual( size, previous->size ) )
+		{
+			differences->clear();
+		}
+	}
+};
@@ -10,59 +10,79 @@
 #include <functional>
 #include <optional>
 #include <array>
+#include <future>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <numeric>
+#include <cfloat>
+
+#if __LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 #define RAYMATH_IMPLEMENTATION
 #include <raymath.h>
+#define ALLOCATION_TRACKER_IMPLEMENTATION
+#include <allocations.hpp>
+#include <rlgl.h>
 
 #include <imgui.h>
 #include <rlImGui.h>
 #include <nlohmann/json.hpp>
 
-using namespace std;
-
-class BaseException : public std::exception
-{
-public:
-	BaseException( const string& _message ) : message( _message ) { }
-
-	const char* what() const noexcept override { return message.c_str(); }
+#include <level.hpp>
+#include <pathfinder.hpp>
+#include <simulation.hpp>
+#include <ghost.hpp>
+#include <profiler.hpp>
+#include <rewind.hpp>
+#include <crowd.hpp>
 
-protected:
-	const string message;
-};
+using namespace std;
 
 namespace ImGui {
-	void CenterWindowForText( const string& text )
+	void CenterWindow( const float contentWidth )
 	{
-		const ImVec2 textSize = ImGui::CalcTextSize( text.c_str() );
-		const float windowWidth = textSize.x + 100;
+		const float windowWidth = contentWidth + 100;
 		const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
 		ImGui::SetNextWindowPos( ImVec2( displaySize.x * 0.5f - windowWidth / 2, displaySize.y * 0.1f ) );
 		ImGui::SetNextWindowSize( ImVec2( windowWidth, 0 ) );
 	}
 
-	bool CenteredButton( const string& label )
+	void CenterWindowForText( const char* text )
 	{
-		const ImVec2 textSize = ImGui::CalcTextSize( label.c_str() );
+		CenterWindow( ImGui::CalcTextSize( text ).x );
+	}
+
+	bool CenteredButton( const char* label )
+	{
+		const ImVec2 textSize = ImGui::CalcTextSize( label );
 		ImGui::NewLine();
 		ImGui::SameLine( ( ImGui::GetContentRegionAvail().x - textSize.x ) / 2 );
-		return ImGui::Button( label.c_str() );
+		return ImGui::Button( label );
 	}
 
-	void CenteredText( const string& label )
+	void CenteredText( const char* label )
 	{
-		const ImVec2 textSize = ImGui::CalcTextSize( label.c_str() );
+		const ImVec2 textSize = ImGui::CalcTextSize( label );
 		ImGui::NewLine();
 		ImGui::SameLine( ( ImGui::GetContentRegionAvail().x - textSize.x ) / 2 );
-		ImGui::Text( label.c_str() );
+		ImGui::Text( label );
 	}
 
-	void CenteredTextDisabled( const string& label )
+	void CenteredTextDisabled( const char* label )
 	{
-		const ImVec2 textSize = ImGui::CalcTextSize( label.c_str() );
+		const ImVec2 textSize = ImGui::CalcTextSize( label );
 		ImGui::NewLine();
 		ImGui::SameLine( ( ImGui::GetContentRegionAvail().x - textSize.x ) / 2 );
-		ImGui::TextDisabled( label.c_str() );
+		ImGui::TextDisabled( label );
 	}
 
 #if __RELEASE
@@ -78,541 +98,578 @@ namespace ImGui {
 #endif
 }
 
-class Tiles
+static std::filesystem::path getUserDataPath()
 {
-public:
-	const int tileSize;
+#if __WINDOWS
+	const std::filesystem::path home = std::getenv( "APPDATA" );
+#else
+	const std::filesystem::path home = std::getenv( "HOME" );
+#endif
+	return home / ".robodaniel";
+}
 
-	Tiles( const string& path, const int _tileSize ) : tileSize( _tileSize )
-	{
-		texture = LoadTexture( path.c_str() );
-		tilesPerSide.x = texture.width / tileSize;
-		tilesPerSide.y = texture.height / tileSize;
-	}
+// Worker threads where there are threads; elsewhere jobs run when their result is first asked for
+static launch getJobLaunchPolicy()
+{
+#if __WEB
+	return launch::deferred;
+#else
+	return launch::async;
+#endif
+}
 
-	~Tiles()
-	{
-		UnloadTexture( texture );
-	}
+template<typename T> static bool isReady( const future<T>& job )
+{
+	return job.valid() && job.wait_for( chrono::seconds( 0 ) ) != future_status::timeout;
+}
 
-	const Texture& getTexture() const
+// FNV-1a
+static void hashBytes( uint64_t& hash, const void* data, const size_t size )
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>( data );
+	for ( size_t i = 0; i < size; ++i )
 	{
-		return texture;
+		hash = ( hash ^ bytes[ i ] ) * 0x100000001b3ull;
 	}
+}
 
-	Rectangle getRectangleForTile( const int tile ) const
+// Stores the baked ImGui font atlas on disk, so that fonts are rasterized again only when files, sizes or glyph ranges change
+class FontAtlasCache
+{
+public:
+	struct Font
 	{
-		Rectangle rectangle;
-		rectangle.x = ( tile % tilesPerSide.x ) * tileSize;
-		rectangle.y = ( tile / tilesPerSide.x ) * tileSize;
-		rectangle.width = tileSize;
-		rectangle.height = tileSize;
-		return rectangle;
-	}
+		string path;
+		float size;
+	};
 
-	static int getEmpty()
-	{
-		return -1;
-	}
+	// A disabled cache rasterizes the fonts on every launch, as before the cache existed, to compare startup times
+	FontAtlasCache( const filesystem::path& _cachePath, const bool _enabled = true ) : cachePath( _cachePath ), enabled( _enabled ) { }
 
-	static bool isGround( const int tile )
+	// Fills the ImGui font atlas and returns the fonts in the requested order. Nothing is uploaded, so that this can run on a
+	// worker thread while ImGui is not used; rlImGuiReloadFonts uploads the atlas afterwards.
+	vector<ImFont*> build( const vector<Font>& fonts, const ImWchar* glyphRanges )
 	{
-		return tile == 0 || tile == 1;
-	}
+		ImFontAtlas& atlas = *ImGui::GetIO().Fonts;
+		atlas.Clear();
 
-	static bool isImpassable( const int tile )
-	{
-		return isGround( tile );
-	}
+		vector<ImFont*> result;
+		const uint64_t key = computeKey( fonts, glyphRanges );
+		if ( enabled && loadAtlas( atlas, key ) && atlas.Fonts.Size == int( fonts.size() ) )
+		{
+			result.assign( atlas.Fonts.begin(), atlas.Fonts.end() );
+		} else
+		{
+			atlas.Clear();
+			hit = false;
+			for ( const Font& font : fonts )
+			{
+				result.push_back( atlas.AddFontFromFileTTF( font.path.c_str(), font.size, nullptr, glyphRanges ) );
+			}
+			atlas.Build();
+			if ( enabled )
+			{
+				saveAtlas( atlas, key );
+			}
+		}
 
-	static int getHero()
-	{
-		return 32;
+		// Converted here too, so that the upload is all that is left for the main thread
+		unsigned char* pixels;
+		int width;
+		int height;
+		atlas.GetTexDataAsRGBA32( &pixels, &width, &height );
+		return result;
 	}
 
-	static const vector<int>& getHeroIdleAnimation()
+	bool isHit() const
 	{
-		static const vector<int> animation{ 32, 33, 34, 35, 36, 37, 38, 39, 40, 41 };
-		return animation;
+		return hit;
 	}
 
-	static const vector<int>& getHeroIdleMirroredAnimation()
+	bool isEnabled() const
 	{
-		static const vector<int> animation{ 42, 43, 44, 45, 46, 47, 48, 49, 50, 51 };
-		return animation;
+		return enabled;
 	}
 
-	static const vector<int>& getHeroJumpAnimation()
-	{
-		static const vector<int> animation{ 52, 53, 54, 55, 56, 57, 58, 59, 60, 61 };
-		return animation;
-	}
+private:
+	static constexpr uint32_t magic = 0x43464452;
+	static constexpr uint32_t formatVersion = 1;
 
-	static const vector<int>& getHeroJumpMirroredAnimation()
-	{
-		static const vector<int> animation{ 62, 63, 64, 65, 66, 67, 68, 69, 70, 71 };
-		return animation;
-	}
+	filesystem::path cachePath;
+	bool enabled = true;
+	bool hit = false;
 
-	static const vector<int>& getHeroRunAnimation()
+	static uint64_t computeKey( const vector<Font>& fonts, const ImWchar* glyphRanges )
 	{
-		static const vector<int> animation{ 72, 73, 74, 75, 76, 77, 78, 79 };
-		return animation;
-	}
+		uint64_t hash = 0xcbf29ce484222325ull;
 
-	static const vector<int>& getHeroRunMirroredAnimation()
-	{
-		static const vector<int> animation{ 80, 81, 82, 83, 84, 85, 86, 87 };
-		return animation;
-	}
+		const int imguiVersion = IMGUI_VERSION_NUM;
+		hashBytes( hash, &formatVersion, sizeof( formatVersion ) );
+		hashBytes( hash, &imguiVersion, sizeof( imguiVersion ) );
 
-	static int getCoin()
-	{
-		return 2;
+		for ( const Font& font : fonts )
+		{
+			ifstream stream( font.path, ios::binary );
+			const string contents( ( istreambuf_iterator<char>( stream ) ), istreambuf_iterator<char>() );
+			hashBytes( hash, contents.data(), contents.size() );
+			hashBytes( hash, &font.size, sizeof( font.size ) );
+		}
+
+		for ( const ImWchar* range = glyphRanges; *range; ++range )
+		{
+			hashBytes( hash, range, sizeof( ImWchar ) );
+		}
+
+		return hash;
 	}
 
-	static int getClosedExit()
+	template<typename T> static void write( ofstream& stream, const T& value )
 	{
-		return 3;
+		stream.write( reinterpret_cast<const char*>( &value ), sizeof( T ) );
 	}
 
-	static int getOpenExit()
+	template<typename T> static void writeVector( ofstream& stream, const ImVector<T>& values )
 	{
-		return 4;
+		write( stream, values.Size );
+		stream.write( reinterpret_cast<const char*>( values.Data ), sizeof( T ) * values.Size );
 	}
 
-	static int getEnemy()
+	template<typename T> static bool read( ifstream& stream, T& value )
 	{
-		return 5;
+		return bool( stream.read( reinterpret_cast<char*>( &value ), sizeof( T ) ) );
 	}
 
-	static bool isEnemyBlueprint( const int tile )
+	template<typename T> static bool readVector( ifstream& stream, ImVector<T>& values )
 	{
-		return tile >= 256 && tile <= 272;
+		int size;
+		if ( !read( stream, size ) || size < 0 )
+		{
+			return false;
+		}
+		values.resize( size );
+		return bool( stream.read( reinterpret_cast<char*>( values.Data ), sizeof( T ) * size ) );
 	}
 
-	static void getEnemyBlueprintProperties( const int tile, int& pathLength, bool& horizontal, bool& startsAtEnd )
+	void saveAtlas( const ImFontAtlas& atlas, const uint64_t key ) const
 	{
-		switch ( tile )
+		if ( !atlas.TexPixelsAlpha8 )
 		{
-		case 257:
-			pathLength = 3;
-			horizontal = false;
-			startsAtEnd = false;
-			break;
-
-		case 258:
-			pathLength = 4;
-			horizontal = false;
-			startsAtEnd = false;
-			break;
-
-		case 259:
-			pathLength = 6;
-			horizontal = false;
-			startsAtEnd = false;
-			break;
-
-		case 260:
-			pathLength = 12;
-			horizontal = false;
-			startsAtEnd = false;
-			break;
-
-		case 261:
-			pathLength = 3;
-			horizontal = true;
-			startsAtEnd = false;
-			break;
-
-		case 262:
-			pathLength = 4;
-			horizontal = true;
-			startsAtEnd = false;
-			break;
-
-		case 263:
-			pathLength = 6;
-			horizontal = true;
-			startsAtEnd = false;
-			break;
-
-		case 264:
-			pathLength = 12;
-			horizontal = true;
-			startsAtEnd = false;
-			break;
-
-		case 265:
-			pathLength = 3;
-			horizontal = true;
-			startsAtEnd = true;
-			break;
-
-		case 266:
-			pathLength = 4;
-			horizontal = true;
-			startsAtEnd = true;
-			break;
-
-		case 267:
-			pathLength = 6;
-			horizontal = true;
-			startsAtEnd = true;
-			break;
-
-		case 268:
-			pathLength = 12;
-			horizontal = true;
-			startsAtEnd = true;
-			break;
+			return;
+		}
 
-		case 269:
-			pathLength = 3;
-			horizontal = false;
-			startsAtEnd = true;
-			break;
+		error_code ec;
+		filesystem::create_directories( cachePath.parent_path(), ec );
+
+		// Written under a name of its own first, so that a crash or a second instance never leaves a torn cache behind
+		filesystem::path temporaryPath = cachePath;
+		temporaryPath += ".tmp";
+		ofstream stream( temporaryPath, ios::binary | ios::trunc );
+		write( stream, magic );
+		write( stream, key );
+		write( stream, atlas.Flags );
+		write( stream, atlas.TexWidth );
+		write( stream, atlas.TexHeight );
+		write( stream, atlas.TexUvWhitePixel );
+		write( stream, atlas.TexUvLines );
+		write( stream, atlas.PackIdMouseCursor );
+		write( stream, atlas.PackIdLines );
+		writeVector( stream, atlas.CustomRects );
+
+		write( stream, atlas.Fonts.Size );
+		for ( const ImFont* font : atlas.Fonts )
+		{
+			write( stream, font->FontSize );
+			write( stream, font->Ascent );
+			write( stream, font->Descent );
+			writeVector( stream, font->Glyphs );
+		}
 
-		case 270:
-			pathLength = 4;
-			horizontal = false;
-			startsAtEnd = true;
-			break;
+		stream.write( reinterpret_cast<const char*>( atlas.TexPixelsAlpha8 ), size_t( atlas.TexWidth ) * atlas.TexHeight );
+		stream.close();
+		if ( !stream )
+		{
+			TraceLog( LOG_WARNING, "Cannot write font cache %s", temporaryPath.string().c_str() );
+			filesystem::remove( temporaryPath, ec );
+			return;
+		}
 
-		case 271:
-			pathLength = 6;
-			horizontal = false;
-			startsAtEnd = true;
-			break;
-
-		case 272:
-			pathLength = 12;
-			horizontal = false;
-			startsAtEnd = true;
-			break;
+		filesystem::rename( temporaryPath, cachePath, ec );
+		if ( ec )
+		{
+			TraceLog( LOG_WARNING, "Cannot replace font cache %s: %s", cachePath.string().c_str(), ec.message().c_str() );
 		}
 	}
 
-private:
-	Texture texture;
-	Vector2Int tilesPerSide;
-};
-
-class Level
-{
-public:
-	Level( const filesystem::path& path )
+	bool loadAtlas( ImFontAtlas& atlas, const uint64_t key )
 	{
-		ifstream stream( path );
-		int rows = 0;
-		string line;
-		while ( std::getline( stream, line ) )
+		hit = false;
+
+		ifstream stream( cachePath, ios::binary );
+		uint32_t fileMagic;
+		uint64_t fileKey;
+		if ( !read( stream, fileMagic ) || fileMagic != magic || !read( stream, fileKey ) || fileKey != key )
 		{
-			++rows;
+			return false;
+		}
 
-			stringstream lineStream( line );
-			string svalue;
+		int fontCount;
+		if ( !read( stream, atlas.Flags ) || !read( stream, atlas.TexWidth ) || !read( stream, atlas.TexHeight ) || !read( stream, atlas.TexUvWhitePixel ) || !read( stream, atlas.TexUvLines )
+			|| !read( stream, atlas.PackIdMouseCursor ) || !read( stream, atlas.PackIdLines ) || !readVector( stream, atlas.CustomRects ) || !read( stream, fontCount ) || fontCount <= 0 )
+		{
+			return false;
+		}
 
-			while ( std::getline( lineStream, svalue, ',' ) )
+		// Fonts have no source data: the atlas is already baked
+		atlas.ConfigData.resize( fontCount );
+		for ( int i = 0; i < fontCount; ++i )
+		{
+			ImFontConfig& config = atlas.ConfigData[ i ];
+			config = ImFontConfig();
+			config.FontDataOwnedByAtlas = false;
+
+			ImFont* font = IM_NEW( ImFont );
+			atlas.Fonts.push_back( font );
+			font->ContainerAtlas = &atlas;
+			font->ConfigData = &config;
+			font->ConfigDataCount = 1;
+			config.DstFont = font;
+
+			if ( !read( stream, font->FontSize ) || !read( stream, font->Ascent ) || !read( stream, font->Descent ) || !readVector( stream, font->Glyphs ) )
 			{
-				const int value = std::stoi( svalue );
-				cells.push_back( value );
+				return false;
 			}
+			config.SizePixels = font->FontSize;
+			font->BuildLookupTable();
 		}
 
-		size.y = rows;
-		size.x = cells.size() / rows;
-	}
+		const size_t pixelCount = size_t( atlas.TexWidth ) * atlas.TexHeight;
+		atlas.TexPixelsAlpha8 = static_cast<unsigned char*>( IM_ALLOC( pixelCount ) );
+		if ( !stream.read( reinterpret_cast<char*>( atlas.TexPixelsAlpha8 ), pixelCount ) )
+		{
+			return false;
+		}
 
-	const Vector2Int getSize() const
-	{
-		return size;
+		atlas.TexUvScale = ImVec2( 1.0f / atlas.TexWidth, 1.0f / atlas.TexHeight );
+		atlas.TexReady = true;
+		hit = true;
+		return true;
 	}
+};
 
-	int getCellAt( const Vector2Int& coords ) const
-	{
-		const int cellIndex = coords.y * size.x + coords.x;
-		return cells.at( cellIndex );
-	}
+// Glyphs for the dev UI plus every character appearing in languages.json
+static ImVector<ImWchar> buildGlyphRanges()
+{
+	ImFontGlyphRangesBuilder builder;
+	const ImWchar basicLatin[] = { 0x0020, 0x007E, 0 };
+	builder.AddRanges( basicLatin );
 
-	void setCellAt( const Vector2Int& coords, const int tile )
+	nlohmann::json allLanguages;
+	ifstream stream( "languages.json" );
+	stream >> allLanguages;
+	for ( const auto& language : allLanguages.items() )
 	{
-		if ( coords.x < 0 || coords.x >= size.x || coords.y < 0 || coords.y >= size.y )
+		for ( const auto& entry : language.value().items() )
 		{
-			throw BaseException( "Coords out of bounds" );
+			builder.AddText( entry.key().c_str() );
+			builder.AddText( entry.value().get<string>().c_str() );
 		}
-
-		const int cellIndex = coords.y * size.x + coords.x;
-		cells.at( cellIndex ) = tile;
 	}
 
-	Vector2Int findFirstCell( const int tile )
+	ImVector<ImWchar> ranges;
+	builder.BuildRanges( &ranges );
+	return ranges;
+}
+
+// Level previews for the level select screen, drawn on the CPU by worker threads and cached on disk by level content. Only the
+// levels asked for are read, so the screen can ask for the visible ones alone.
+class LevelThumbnails
+{
+public:
+	static constexpr int width = 192;
+	static constexpr int height = 108;
+
+	LevelThumbnails( const Tiles& _tiles, const filesystem::path& _cacheDirectory ) : tiles( _tiles ), cacheDirectory( _cacheDirectory ) { }
+
+	~LevelThumbnails()
 	{
-		for ( int i = 0; i < size.y; ++i )
+		for ( auto& [ levelIndex, thumbnail ] : thumbnails )
 		{
-			for ( int j = 0; j < size.x; ++j )
+			if ( thumbnail.job.valid() )
 			{
-				const Vector2Int coords{ j, i };
-				if ( getCellAt( coords ) == tile )
-				{
-					return coords;
-				}
+				UnloadImage( thumbnail.job.get() );
+			}
+			if ( thumbnail.texture.id )
+			{
+				UnloadTexture( thumbnail.texture );
 			}
 		}
-
-		return Vector2Int{ -1, -1 };
 	}
 
-	vector<Vector2Int> findAllCells( const int tile )
-	{
-		vector<Vector2Int> result;
+	LevelThumbnails( const LevelThumbnails& ) = delete;
+	LevelThumbnails& operator=( const LevelThumbnails& ) = delete;
 
-		for ( int i = 0; i < size.y; ++i )
+	// Uploads every thumbnail whose job finished, including those of levels no longer on screen; called once per frame
+	void update()
+	{
+		for ( auto& [ levelIndex, thumbnail ] : thumbnails )
 		{
-			for ( int j = 0; j < size.x; ++j )
+			if ( isReady( thumbnail.job ) )
 			{
-				const Vector2Int coords{ j, i };
-				if ( getCellAt( coords ) == tile )
+				const Image image = thumbnail.job.get();
+				--pendingJobs;
+				if ( image.data )
 				{
-					result.push_back( coords );
+					thumbnail.texture = LoadTextureFromImage( image );
+					SetTextureFilter( thumbnail.texture, TEXTURE_FILTER_BILINEAR );
 				}
+				UnloadImage( image );
+				thumbnail.done = true;
 			}
 		}
+	}
 
-		return result;
+	// The level's thumbnail, width by height pixels, or nullptr until it is ready or if the level cannot be read
+	const Texture2D* get( const int levelIndex, const filesystem::path& levelPath )
+	{
+		Thumbnail& thumbnail = thumbnails[ levelIndex ];
+		if ( !thumbnail.done && !thumbnail.job.valid() )
+		{
+			thumbnail.job = async( getJobLaunchPolicy(), &LevelThumbnails::makeThumbnail, cref( tiles ), cacheDirectory, levelPath, levelIndex );
+			++pendingJobs;
+		}
+
+		return thumbnail.texture.id ? &thumbnail.texture : nullptr;
 	}
 
-private:
-	Vector2Int size;
-	vector<int> cells;
-};
+	// Whether thumbnails asked for are still being made, so that the screen must keep redrawing to show them
+	bool isLoading() const
+	{
+		return pendingJobs > 0;
+	}
 
-struct PathPoint
-{
-	Vector2 coords;
-	float progress;
-	unsigned int moveFlags;
-};
+	// Makes the level's thumbnail again the next time it is asked for, for when its file changed
+	void invalidate( const int levelIndex )
+	{
+		const auto it = thumbnails.find( levelIndex );
+		if ( it == thumbnails.end() )
+		{
+			return;
+		}
 
-enum MoveFlags
-{
-	MoveFlags_None = 0x0,
-	MoveFlags_NeedsSolidBottom = 0x1,
-	MoveFlags_JumpAnimation = 0x2,
-	MoveFlags_MirroredAnimation = 0x4,
-};
+		if ( it->second.job.valid() )
+		{
+			UnloadImage( it->second.job.get() );
+			--pendingJobs;
+		}
+		if ( it->second.texture.id )
+		{
+			UnloadTexture( it->second.texture );
+		}
+		thumbnails.erase( it );
+	}
 
-class Pathfinder
-{
 private:
-	struct Move
-	{
-		string description;
-		unsigned int flags;
-		vector<Vector2Int> steps;
-	};
+	static constexpr uint32_t formatVersion = 1;
 
-	const vector<Move> moves
+	struct Thumbnail
 	{
-		{ "Right", MoveFlags_NeedsSolidBottom, { { 1, 0 } } },
-		{ "Right Long Jump", MoveFlags_NeedsSolidBottom | MoveFlags_JumpAnimation, { { 1, -1 }, { 2, -1 }, { 3, 0 } } },
-		{ "Right High Jump", MoveFlags_NeedsSolidBottom | MoveFlags_JumpAnimation, { { 0, -1 }, { 0, -2 }, { 0, -3 }, { 1, -3 } } },
-		{ "Left", MoveFlags_NeedsSolidBottom | MoveFlags_MirroredAnimation, { { -1, 0 } } },
-		{ "Left Long Jump", MoveFlags_NeedsSolidBottom | MoveFlags_MirroredAnimation | MoveFlags_JumpAnimation, { { -1, -1 }, { -2, -1 }, { -3, 0 } } },
-		{ "Left High Jump", MoveFlags_NeedsSolidBottom | MoveFlags_MirroredAnimation | MoveFlags_JumpAnimation, { { 0, -1 }, { 0, -2 }, { 0, -3 }, { -1, -3 } } },
-		{ "Gravity", MoveFlags_JumpAnimation, { { 0, 1 } } },
+		future<Image> job;
+		Texture2D texture{};
+		bool done = false;
 	};
 
-public:
-	Pathfinder( const Tiles& _tiles, const Level& _level ) : tiles( _tiles ), level( _level ) { }
+	const Tiles& tiles;
+	filesystem::path cacheDirectory;
+	unordered_map<int, Thumbnail> thumbnails;
+	int pendingJobs = 0;
 
-	vector<PathPoint> goTo( const Vector2Int& currentPosition, const Vector2Int& destination )
+	// Runs on a worker thread: decodes the cached thumbnail for the level's content, or draws and caches it
+	static Image makeThumbnail( const Tiles& tiles, const filesystem::path& cacheDirectory, const filesystem::path& levelPath, const int levelIndex )
 	{
-		if ( Vector2IntEqual( currentPosition, destination ) )
+		ifstream stream( levelPath, ios::binary );
+		if ( !stream )
+		{
+			return Image{};
+		}
+		const string contents( ( istreambuf_iterator<char>( stream ) ), istreambuf_iterator<char>() );
+
+		uint64_t hash = 0xcbf29ce484222325ull;
+		hashBytes( hash, &formatVersion, sizeof( formatVersion ) );
+		hashBytes( hash, &width, sizeof( width ) );
+		hashBytes( hash, &height, sizeof( height ) );
+		hashBytes( hash, contents.data(), contents.size() );
+		char name[ 32 ];
+		snprintf( name, sizeof( name ), "%016llx.png", static_cast<unsigned long long>( hash ) );
+		const filesystem::path cachePath = cacheDirectory / name;
+
+		error_code ec;
+		if ( filesystem::exists( cachePath, ec ) )
 		{
-			return vector<PathPoint>();
+			Image image = LoadImage( cachePath.string().c_str() );
+			if ( image.data && image.width == width && image.height == height )
+			{
+				return image;
+			}
+			UnloadImage( image );
 		}
 
-		struct CellState
+		Image image;
+		try
 		{
-			float shortestPath = -1;
-			vector<Vector2Int> trajectory;
-			unsigned int moveFlags;
-		};
+			image = drawThumbnail( Level( levelPath ), tiles );
+		} catch ( const exception& e )
+		{
+			TraceLog( LOG_WARNING, "Cannot draw a thumbnail of %s: %s", levelPath.string().c_str(), e.what() );
+			return Image{};
+		}
+
+		// Written under a name of its own first, so that a thumbnail being written is never read
+		filesystem::create_directories( cacheDirectory, ec );
+		const filesystem::path temporaryPath = cacheDirectory / ( "level" + to_string( levelIndex ) + ".tmp.png" );
+		if ( ExportImage( image, temporaryPath.string().c_str() ) )
+		{
+			filesystem::rename( temporaryPath, cachePath, ec );
+		}
 
-		vector<CellState> cellStates( level.getSize().x * level.getSize().y );
-		auto cellAt = [ &cellStates, mapWidth = level.getSize().x ]( const Vector2Int& position )->CellState& { return cellStates.at( position.y * mapWidth + position.x ); };
+		return image;
+	}
 
-		queue<Vector2Int> positionsToVisit;
-		cellAt( currentPosition ).shortestPath = 0;
-		positionsToVisit.push( currentPosition );
+	// Every tile is scaled once to the cell size and copied into the cells showing it; the level is then fitted into the thumbnail
+	static Image drawThumbnail( const Level& level, const Tiles& tiles )
+	{
+		const Color skyColor{ 208, 244, 247, 255 };
+		const Vector2Int size = level.getSize();
+		const int cellSize = std::clamp( std::min( width / size.x, height / size.y ), 1, int( Tiles::minTileSize ) );
 
-		while ( !positionsToVisit.empty() )
+		Image levelImage = GenImageColor( size.x * cellSize, size.y * cellSize, skyColor );
+		unordered_map<int, Image> tileImages;
+		for ( int i = 0; i < size.y; ++i )
 		{
-			Vector2Int position = positionsToVisit.front();
-			positionsToVisit.pop();
-
-			CellState& currentCell = cellAt( position );
-			for ( const Move& move : moves )
+			for ( int j = 0; j < size.x; ++j )
 			{
-				if ( move.flags & MoveFlags_NeedsSolidBottom )
+				int tile = level.getCellAt( Vector2Int{ j, i } );
+				if ( Tiles::isEnemyBlueprint( tile ) )
 				{
-					if ( position.y + 1 >= level.getSize().y || !Tiles::isImpassable( level.getCellAt( Vector2Int{ position.x, position.y + 1 } ) ) )
-					{
-						continue;
-					}
+					tile = Tiles::getEnemy();
 				}
-
-				vector<Vector2Int> trajectory;
-				trajectory.push_back( position );
-
-				for ( const Vector2Int& delta : move.steps )
+				if ( tile < 0 || tile >= tiles.getTileCount() )
 				{
-					const Vector2Int stepPosition = Vector2IntAdd( position, delta );
-					if ( stepPosition.x < 0 || stepPosition.x >= level.getSize().x || stepPosition.y < 0 || stepPosition.y >= level.getSize().y )
-					{
-						break;
-					}
-					if ( Tiles::isImpassable( level.getCellAt( stepPosition ) ) )
-					{
-						break;
-					}
-
-					trajectory.push_back( stepPosition );
+					continue;
 				}
 
-				float currentPathLength = currentCell.shortestPath;
-				for ( int step = 1; step < trajectory.size(); ++step )
+				auto it = tileImages.find( tile );
+				if ( it == tileImages.end() )
 				{
-					currentPathLength += Vector2Distance( Vector2IntToFloat( trajectory.at( step - 1 ) ), Vector2IntToFloat( trajectory.at( step ) ) );
-
-					CellState& cell = cellAt( trajectory.at( step ) );
-					if ( cell.shortestPath < 0 || currentPathLength < cell.shortestPath )
-					{
-						cell.shortestPath = currentPathLength;
-						cell.trajectory = trajectory;
-						cell.moveFlags = move.flags;
+					it = tileImages.emplace( tile, tiles.createTileImage( tile, cellSize ) ).first;
+				}
 
-						if ( step == trajectory.size() - 1 )
-						{
-							positionsToVisit.push( trajectory.at( step ) );
-						}
-					}
+				if ( cellSize == 1 )
+				{
+					ImageDrawPixel( &levelImage, j, i, GetImageColor( it->second, 0, 0 ) );
+				} else
+				{
+					const float cell = float( cellSize );
+					ImageDraw( &levelImage, it->second, Rectangle{ 0, 0, cell, cell }, Rectangle{ j * cell, i * cell, cell, cell }, WHITE );
 				}
 			}
 		}
-
-		const CellState& destinationCell = cellAt( destination );
-		if ( destinationCell.shortestPath == -1 )
+		for ( const auto& [ tile, image ] : tileImages )
 		{
-			return vector<PathPoint>();
+			UnloadImage( image );
 		}
 
-		vector<Vector2Int> pathPositions;
-		{
-			Vector2Int position = destination;
-			while ( true )
-			{
-				pathPositions.push_back( position );
-				if ( Vector2IntEqual( position, currentPosition ) )
-				{
-					break;
-				}
+		const float scale = std::min( float( width ) / levelImage.width, float( height ) / levelImage.height );
+		const float fittedWidth = levelImage.width * scale;
+		const float fittedHeight = levelImage.height * scale;
+		Image thumbnail = GenImageColor( width, height, skyColor );
+		ImageDraw( &thumbnail, levelImage, Rectangle{ 0, 0, float( levelImage.width ), float( levelImage.height ) }, Rectangle{ ( width - fittedWidth ) / 2, ( height - fittedHeight ) / 2, fittedWidth, fittedHeight }, WHITE );
+		UnloadImage( levelImage );
+		return thumbnail;
+	}
+};
 
-				position = cellAt( position ).trajectory.front();
-			}
+#if __LINUX
+class LevelWatcher
+{
+public:
+	LevelWatcher()
+	{
+		inotifyFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	}
 
-			std::reverse( pathPositions.begin(), pathPositions.end() );
+	~LevelWatcher()
+	{
+		if ( inotifyFd >= 0 )
+		{
+			close( inotifyFd );
 		}
+	}
 
-		vector<PathPoint> trajectory;
-		trajectory.push_back( PathPoint{ Vector2IntToFloat( currentPosition ), 0 } );
-		float progressOffset = 0;
-		Vector2Int lastPosition = currentPosition;
-		for ( int i = 1; i < pathPositions.size(); ++i )
+	LevelWatcher( const LevelWatcher& ) = delete;
+	LevelWatcher& operator=( const LevelWatcher& ) = delete;
+
+	void watch( const filesystem::path& path )
+	{
+		if ( inotifyFd < 0 )
 		{
-			const CellState& cell = cellAt( pathPositions.at( i ) );
-			vector<PathPoint> smoothPath = catmullClark( cell.trajectory, 2, progressOffset, cell.moveFlags );
-			trajectory.insert( trajectory.end(), smoothPath.begin() + 1, smoothPath.end() );
-			progressOffset += cell.trajectory.size() - 1;
-			lastPosition = cell.trajectory.back();
+			return;
 		}
 
-		while ( true )
+		if ( watchDescriptor >= 0 )
 		{
-			const Vector2Int below{ lastPosition.x, lastPosition.y + 1 };
-			if ( below.y >= level.getSize().y )
-			{
-				trajectory.push_back( PathPoint{ Vector2IntToFloat( below ), trajectory.back().progress + 1, MoveFlags_JumpAnimation } );
-				break;
-			} else if ( !Tiles::isImpassable( level.getCellAt( below ) ) )
-			{
-				trajectory.push_back( PathPoint{ Vector2IntToFloat( below ), trajectory.back().progress + 1, MoveFlags_JumpAnimation } );
-				lastPosition = below;
-				continue;
-			} else
-			{
-				break;
-			}
+			inotify_rm_watch( inotifyFd, watchDescriptor );
 		}
 
-		return trajectory;
+		// Watch the directory rather than the file, since exporters often replace the file with a rename
+		const filesystem::path absolutePath = filesystem::absolute( path );
+		fileName = absolutePath.filename().string();
+		watchDescriptor = inotify_add_watch( inotifyFd, absolutePath.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO );
 	}
 
-private:
-	const Tiles& tiles;
-	const Level& level;
-
-	vector<PathPoint> catmullClark( const vector<Vector2Int> path, const int iterations, const float progressOffset, const unsigned int moveFlags )
+	bool poll()
 	{
-		vector<PathPoint> points;
-		for ( int i = 0; i < path.size(); ++i )
-		{
-			points.push_back( PathPoint{ Vector2IntToFloat( path.at( i ) ), progressOffset + i, moveFlags } );
-		}
-
-		if ( points.size() < 3 )
+		if ( inotifyFd < 0 || watchDescriptor < 0 )
 		{
-			return points;
+			return false;
 		}
 
-		int iterationsToDo = iterations;
-		while ( iterationsToDo-- )
+		bool changed = false;
+		alignas( inotify_event ) char buffer[ 4096 ];
+		while ( true )
 		{
-			vector<PathPoint> midpoints;
-			midpoints.reserve( points.size() - 1 );
-			for ( int i = 0; i < points.size() - 1; ++i )
+			const ssize_t length = read( inotifyFd, buffer, sizeof( buffer ) );
+			if ( length <= 0 )
 			{
-				PathPoint midpoint;
-				midpoint.coords = Vector2Scale( Vector2Add( points.at( i ).coords, points.at( i + 1 ).coords ), 0.5f );
-				midpoint.progress = ( points.at( i ).progress + points.at( i + 1 ).progress ) / 2;
-				midpoint.moveFlags = moveFlags;
-				midpoints.push_back( midpoint );
+				break;
 			}
 
-			vector<PathPoint> subdivided;
-			subdivided.reserve( points.size() + midpoints.size() );
-			subdivided.push_back( points.front() );
-			for ( int i = 0; i < midpoints.size() - 1; ++i )
+			for ( ssize_t offset = 0; offset < length; )
 			{
-				subdivided.push_back( midpoints.at( i ) );
-
-				PathPoint newPoint;
-				newPoint.coords.x = points.at( i + 1 ).coords.x * 0.5f + midpoints.at( i ).coords.x * 0.25f + midpoints.at( i + 1 ).coords.x * 0.25f;
-				newPoint.coords.y = points.at( i + 1 ).coords.y * 0.5f + midpoints.at( i ).coords.y * 0.25f + midpoints.at( i + 1 ).coords.y * 0.25f;
-				newPoint.progress = points.at( i + 1 ).progress;
-				newPoint.moveFlags = moveFlags;
-				subdivided.push_back( newPoint );
+				const inotify_event* event = reinterpret_cast<const inotify_event*>( buffer + offset );
+				if ( event->wd == watchDescriptor && event->len > 0 && fileName == event->name )
+				{
+					changed = true;
+				}
+				offset += sizeof( inotify_event ) + event->len;
 			}
-			subdivided.push_back( midpoints.back() );
-			subdivided.push_back( points.back() );
-
-			points = std::move( subdivided );
 		}
 
-		return points;
+		return changed;
 	}
+
+private:
+	int inotifyFd = -1;
+	int watchDescriptor = -1;
+	string fileName;
+};
+#else
+class LevelWatcher
+{
+public:
+	void watch( const filesystem::path& path ) { }
+	bool poll() { return false; }
 };
+#endif
 
 struct Settings
 {
@@ -623,13 +680,26 @@ struct Settings
 		float coinRadius = 0.4f;
 		float enemySpeed = 4;
 		float enemyRadius = 0.5f;
+		// Rewinding plays time back this many times faster than it passed
+		float rewindSpeed = 2;
 	} gameplay;
 
+	struct
+	{
+		int clouds = 30;
+		bool parallax = false;
+		int parallaxLayers = 3;
+		float parallaxSpeed = 8;
+	} background;
+
 	struct
 	{
 		bool enableDebugCamera = false;
 		Camera2D debugCamera{ Vector2Zero(), Vector2Zero(), 0, 64 };
 		bool pathDebugDraw = false;
+		bool pathHeatmap = false;
+		bool pathStats = false;
+		bool hotReloadLevel = !__RELEASE;
 	} debug;
 };
 
@@ -639,28 +709,50 @@ enum class Language
 	Italian,
 };
 
+// Parses languages.json once into per-language tables indexed by interned source strings, so that translating never allocates
 class Translator
 {
 public:
-	void setLanguage( const Language _language )
+	Translator()
 	{
-		language = _language;
-
-		string languageCode;
-		if ( language == Language::Italian )
-		{
-			languageCode = "it";
-		}
-
 		nlohmann::json allLanguages;
 		ifstream stream( "languages.json" );
 		stream >> allLanguages;
 
-		database = nlohmann::json{};
-		if ( allLanguages.count( languageCode ) )
+		for ( int i = 0; i < languageCodes.size(); ++i )
+		{
+			if ( !allLanguages.count( languageCodes.at( i ) ) )
+			{
+				continue;
+			}
+
+			for ( const auto& entry : allLanguages.at( languageCodes.at( i ) ).items() )
+			{
+				const int id = internSource( entry.key() );
+				vector<const char*>& table = translations.at( i );
+				if ( table.size() <= id )
+				{
+					table.resize( id + 1, nullptr );
+				}
+				table.at( id ) = storeString( entry.value().get<string>() );
+			}
+		}
+
+		for ( vector<const char*>& table : translations )
 		{
-			database = allLanguages.at( languageCode );
+			table.resize( sourceIds.size(), nullptr );
 		}
+
+		setLanguage( Language::English );
+	}
+
+	Translator( const Translator& ) = delete;
+	Translator& operator=( const Translator& ) = delete;
+
+	void setLanguage( const Language _language )
+	{
+		language = _language;
+		currentTranslations = &translations.at( int( language ) );
 	}
 
 	Language getLanguage() const
@@ -668,29 +760,404 @@ public:
 		return language;
 	}
 
-	string translate( const string& source ) const
+	// The result stays valid as long as the translator and the source string do
+	const char* translate( const char* source ) const
 	{
-		return database.count( source ) ? database.at( source ).get<string>() : source;
+		const auto it = sourceIds.find( string_view( source ) );
+		if ( it == sourceIds.end() )
+		{
+			return source;
+		}
+
+		const char* translation = currentTranslations->at( it->second );
+		return translation ? translation : source;
 	}
 
 private:
+	static constexpr array<const char*, 2> languageCodes{ "en", "it" };
 
 	Language language = Language::English;
-	nlohmann::json database;
-};
+	deque<string> strings;
+	unordered_map<string_view, int> sourceIds;
+	array<vector<const char*>, languageCodes.size()> translations;
+	const vector<const char*>* currentTranslations = nullptr;
 
-class Session
-{
-public:
+	const char* storeString( const string& value )
+	{
+		strings.push_back( value );
+		return strings.back().c_str();
+	}
+
+	int internSource( const string& source )
+	{
+		const auto it = sourceIds.find( string_view( source ) );
+		if ( it != sourceIds.end() )
+		{
+			return it->second;
+		}
+
+		const int id = int( sourceIds.size() );
+		sourceIds.emplace( string_view( storeString( source ) ), id );
+		return id;
+	}
+};
+
+// Draws textured quads through one growable vertex buffer, submitting them in a single draw call per run of the same texture
+class SpriteBatch
+{
+public:
+	SpriteBatch() = default;
 
-	struct Enemy
+	~SpriteBatch()
 	{
-		Vector2Int startCell;
-		Vector2Int endCell;
-		float progress = 0;
-		Vector2 position;
+		if ( vertexArrayId != 0 )
+		{
+			rlUnloadVertexArray( vertexArrayId );
+		}
+		if ( vertexBufferId != 0 )
+		{
+			rlUnloadVertexBuffer( vertexBufferId );
+		}
+	}
+
+	SpriteBatch( const SpriteBatch& ) = delete;
+	SpriteBatch& operator=( const SpriteBatch& ) = delete;
+
+	// Same conventions as DrawTexturePro without rotation: a negative source height flips the texture vertically
+	void draw( const Texture& texture, const Rectangle& source, const Rectangle& destination, const Color& tint )
+	{
+		setTexture( texture.id );
+
+		const bool flipY = source.height < 0;
+		const float u0 = source.x / texture.width;
+		const float u1 = ( source.x + source.width ) / texture.width;
+		const float v0 = flipY ? ( source.y - source.height ) / texture.height : source.y / texture.height;
+		const float v1 = flipY ? source.y / texture.height : ( source.y + source.height ) / texture.height;
+
+		addQuad( destination, u0, v0, u1, v1, tint );
+	}
+
+	void drawRectangle( const Rectangle& destination, const Color& color )
+	{
+		setTexture( rlGetTextureIdDefault() );
+		addQuad( destination, 0, 0, 1, 1, color );
+	}
+
+	// Submits the pending quads, honoring the current render target, blend mode and matrices
+	void flush()
+	{
+		if ( vertices.empty() )
+		{
+			return;
+		}
+
+		// Keep ordering with whatever raylib has batched so far
+		rlDrawRenderBatchActive();
+
+		upload();
+
+		const int* shaderLocations = rlGetShaderLocsDefault();
+		const Matrix modelViewProjection = MatrixMultiply( MatrixMultiply( rlGetMatrixTransform(), rlGetMatrixModelview() ), rlGetMatrixProjection() );
+		const float diffuseColor[ 4 ] = { 1, 1, 1, 1 };
+
+		rlEnableShader( rlGetShaderIdDefault() );
+		rlSetUniformMatrix( shaderLocations[ RL_SHADER_LOC_MATRIX_MVP ], modelViewProjection );
+		rlSetUniform( shaderLocations[ RL_SHADER_LOC_COLOR_DIFFUSE ], diffuseColor, RL_SHADER_UNIFORM_VEC4, 1 );
+		rlActiveTextureSlot( 0 );
+		rlEnableTexture( textureId );
+
+		if ( !rlEnableVertexArray( vertexArrayId ) )
+		{
+			rlEnableVertexBuffer( vertexBufferId );
+			setupVertexAttributes();
+		}
+		rlDrawVertexArray( 0, int( vertices.size() ) );
+
+		rlDisableVertexArray();
+		rlDisableVertexBuffer();
+		rlDisableTexture();
+		rlDisableShader();
+
+		vertices.clear();
+		++frameDrawCalls;
+	}
+
+	// Draw calls submitted by all batches during the last completed frame
+	static int getDrawCalls()
+	{
+		return lastFrameDrawCalls;
+	}
+
+	static void endFrame()
+	{
+		lastFrameDrawCalls = frameDrawCalls;
+		frameDrawCalls = 0;
+	}
+
+private:
+	struct Vertex
+	{
+		float x, y, z;
+		float u, v;
+		unsigned char r, g, b, a;
 	};
 
+	inline static int frameDrawCalls = 0;
+	inline static int lastFrameDrawCalls = 0;
+
+	vector<Vertex> vertices;
+	unsigned int textureId = 0;
+	unsigned int vertexArrayId = 0;
+	unsigned int vertexBufferId = 0;
+	size_t vertexBufferCapacity = 0;
+
+	void setTexture( const unsigned int id )
+	{
+		if ( id != textureId )
+		{
+			flush();
+			textureId = id;
+		}
+	}
+
+	void addQuad( const Rectangle& destination, const float u0, const float v0, const float u1, const float v1, const Color& color )
+	{
+		const Vertex topLeft{ destination.x, destination.y, 0, u0, v0, color.r, color.g, color.b, color.a };
+		const Vertex bottomLeft{ destination.x, destination.y + destination.height, 0, u0, v1, color.r, color.g, color.b, color.a };
+		const Vertex bottomRight{ destination.x + destination.width, destination.y + destination.height, 0, u1, v1, color.r, color.g, color.b, color.a };
+		const Vertex topRight{ destination.x + destination.width, destination.y, 0, u1, v0, color.r, color.g, color.b, color.a };
+
+		// Plain triangles instead of indexed quads, since rlgl indices are 16 bits and would cap the batch size
+		vertices.push_back( topLeft );
+		vertices.push_back( bottomLeft );
+		vertices.push_back( bottomRight );
+		vertices.push_back( topLeft );
+		vertices.push_back( bottomRight );
+		vertices.push_back( topRight );
+	}
+
+	void upload()
+	{
+		if ( vertices.size() > vertexBufferCapacity )
+		{
+			vertexBufferCapacity = std::max( vertices.size(), vertexBufferCapacity * 2 );
+
+			if ( vertexArrayId != 0 )
+			{
+				rlUnloadVertexArray( vertexArrayId );
+			}
+			if ( vertexBufferId != 0 )
+			{
+				rlUnloadVertexBuffer( vertexBufferId );
+			}
+
+			vertexArrayId = rlLoadVertexArray();
+			rlEnableVertexArray( vertexArrayId );
+			vertexBufferId = rlLoadVertexBuffer( nullptr, int( vertexBufferCapacity * sizeof( Vertex ) ), true );
+			setupVertexAttributes();
+			rlDisableVertexArray();
+		}
+
+		rlUpdateVertexBuffer( vertexBufferId, vertices.data(), int( vertices.size() * sizeof( Vertex ) ), 0 );
+	}
+
+	void setupVertexAttributes()
+	{
+		rlSetVertexAttribute( RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, sizeof( Vertex ), reinterpret_cast<const void*>( offsetof( Vertex, x ) ) );
+		rlEnableVertexAttribute( RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION );
+		rlSetVertexAttribute( RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 2, RL_FLOAT, false, sizeof( Vertex ), reinterpret_cast<const void*>( offsetof( Vertex, u ) ) );
+		rlEnableVertexAttribute( RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD );
+		rlSetVertexAttribute( RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, sizeof( Vertex ), reinterpret_cast<const void*>( offsetof( Vertex, r ) ) );
+		rlEnableVertexAttribute( RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR );
+	}
+};
+
+// Everything in the world is drawn from one render texture, so that a frame is a single draw call: the tile atlas at the
+// on-screen level of detail is copied at the top, for the sprites, and the level is baked below it at about the
+// on-screen tile size. Levels too big to bake within the texture size limit are drawn cell by cell from the copied tiles.
+class LevelRenderer
+{
+public:
+	LevelRenderer( const Tiles& _tiles, Level& _level, SpriteBatch& _spriteBatch ) : tiles( _tiles ), level( _level ), spriteBatch( _spriteBatch ) { }
+
+	~LevelRenderer()
+	{
+		unloadAtlas();
+	}
+
+	LevelRenderer( const LevelRenderer& ) = delete;
+	LevelRenderer& operator=( const LevelRenderer& ) = delete;
+
+	// Must be called outside of BeginMode2D, since it renders to textures
+	void update( const Camera2D& camera )
+	{
+		const Vector2Int levelSize = level.getSize();
+		const int wantedSpriteLod = tiles.getLevelOfDetail( camera.zoom );
+
+		// Bake at about the on-screen tile size, as big as fits below the tiles
+		const int wantedLevelTop = tiles.getTexture( wantedSpriteLod ).height + Tiles::tilePadding;
+		const int fittingPixelsPerTile = std::min( Tiles::maxTextureSize / levelSize.x, ( Tiles::maxTextureSize - wantedLevelTop ) / levelSize.y );
+		const int wantedPixelsPerTile = std::max( 0, std::min( std::clamp( int( ceilf( camera.zoom ) ), 1, tiles.tileSize ), fittingPixelsPerTile ) );
+
+		if ( atlas.id == 0 || wantedSpriteLod != spriteLod || wantedPixelsPerTile != pixelsPerTile || IsWindowResized() )
+		{
+			spriteLod = wantedSpriteLod;
+			pixelsPerTile = wantedPixelsPerTile;
+			bakeAll();
+			return;
+		}
+
+		const vector<Vector2Int>& changedCells = level.getChangedCells();
+		if ( changedCells.empty() )
+		{
+			return;
+		}
+		if ( pixelsPerTile > 0 )
+		{
+			beginCellWrites();
+			BeginTextureMode( atlas );
+			for ( const Vector2Int& cell : changedCells )
+			{
+				drawCell( cell );
+			}
+			spriteBatch.flush();
+			EndTextureMode();
+			endCellWrites();
+		}
+		level.clearChangedCells();
+	}
+
+	// Must be called inside BeginMode2D, with a camera in tile units; queues the given cells (max excluded)
+	void render( const Vector2Int& visibleMin, const Vector2Int& visibleMax )
+	{
+		if ( atlas.id == 0 || visibleMin.x >= visibleMax.x || visibleMin.y >= visibleMax.y )
+		{
+			return;
+		}
+
+		if ( pixelsPerTile > 0 )
+		{
+			const Vector2Int visibleSize{ visibleMax.x - visibleMin.x, visibleMax.y - visibleMin.y };
+			const Rectangle baked{ float( visibleMin.x * pixelsPerTile ), float( levelTop + visibleMin.y * pixelsPerTile ), float( visibleSize.x * pixelsPerTile ), float( visibleSize.y * pixelsPerTile ) };
+			spriteBatch.draw( atlas.texture, getAtlasSource( baked ), Rectangle{ float( visibleMin.x ), float( visibleMin.y ), float( visibleSize.x ), float( visibleSize.y ) }, WHITE );
+			return;
+		}
+
+		for ( int y = visibleMin.y; y < visibleMax.y; ++y )
+		{
+			for ( int x = visibleMin.x; x < visibleMax.x; ++x )
+			{
+				const int tile = level.getCellAt( Vector2Int{ x, y } );
+				if ( tile != Tiles::getEmpty() )
+				{
+					drawTile( tile, Rectangle{ float( x ), float( y ), 1, 1 }, WHITE );
+				}
+			}
+		}
+	}
+
+	// Queues a sprite from the same texture as the level, so that it does not break the batch; valid after update
+	void drawTile( const int tile, const Rectangle& destination, const Color& tint )
+	{
+		spriteBatch.draw( atlas.texture, getAtlasSource( tiles.getRectangleForTile( tile, spriteLod ) ), destination, tint );
+	}
+
+private:
+	const Tiles& tiles;
+	Level& level;
+	SpriteBatch& spriteBatch;
+
+	RenderTexture2D atlas{};
+	int spriteLod = 0;
+	// Zero when the level is not baked
+	int pixelsPerTile = 0;
+	int cellLod = 0;
+	int levelTop = 0;
+
+	// Render textures are stored upside down: flips a rectangle drawn into the atlas into its source rectangle
+	Rectangle getAtlasSource( const Rectangle& drawn ) const
+	{
+		return Rectangle{ drawn.x, float( atlas.texture.height ) - drawn.y - drawn.height, drawn.width, -drawn.height };
+	}
+
+	void bakeAll()
+	{
+		unloadAtlas();
+
+		const Vector2Int levelSize = level.getSize();
+		const Texture& spriteTexture = tiles.getTexture( spriteLod );
+		cellLod = tiles.getLevelOfDetail( float( std::max( pixelsPerTile, 1 ) ) );
+		levelTop = spriteTexture.height + Tiles::tilePadding;
+
+		const int width = std::max( spriteTexture.width, levelSize.x * pixelsPerTile );
+		const int height = pixelsPerTile > 0 ? levelTop + levelSize.y * pixelsPerTile : spriteTexture.height;
+		atlas = LoadRenderTexture( width, height );
+		// Sprites are scaled like the tile atlas they come from
+		SetTextureFilter( atlas.texture, TEXTURE_FILTER_BILINEAR );
+
+		beginCellWrites();
+		BeginTextureMode( atlas );
+		ClearBackground( BLANK );
+		const Rectangle spriteArea{ 0, 0, float( spriteTexture.width ), float( spriteTexture.height ) };
+		spriteBatch.draw( spriteTexture, spriteArea, spriteArea, WHITE );
+		if ( pixelsPerTile > 0 )
+		{
+			for ( int y = 0; y < levelSize.y; ++y )
+			{
+				for ( int x = 0; x < levelSize.x; ++x )
+				{
+					if ( level.getCellAt( Vector2Int{ x, y } ) != Tiles::getEmpty() )
+					{
+						drawCell( Vector2Int{ x, y } );
+					}
+				}
+			}
+		}
+		spriteBatch.flush();
+		EndTextureMode();
+		endCellWrites();
+
+		level.clearChangedCells();
+	}
+
+	void unloadAtlas()
+	{
+		if ( atlas.id != 0 )
+		{
+			UnloadRenderTexture( atlas );
+			atlas = RenderTexture2D{};
+		}
+	}
+
+	// Cells never overlap, so they are written with blending disabled: this also clears emptied cells and keeps the tile alpha intact
+	void beginCellWrites()
+	{
+		rlSetBlendFactors( RL_ONE, RL_ZERO, RL_FUNC_ADD );
+		BeginBlendMode( BLEND_CUSTOM );
+	}
+
+	void endCellWrites()
+	{
+		EndBlendMode();
+	}
+
+	void drawCell( const Vector2Int& cell )
+	{
+		const Rectangle destination{ float( cell.x * pixelsPerTile ), float( levelTop + cell.y * pixelsPerTile ), float( pixelsPerTile ), float( pixelsPerTile ) };
+		const int tile = level.getCellAt( cell );
+		if ( tile == Tiles::getEmpty() )
+		{
+			spriteBatch.drawRectangle( destination, BLANK );
+		} else
+		{
+			spriteBatch.draw( tiles.getTexture( cellLod ), tiles.getRectangleForTile( tile, cellLod ), destination, WHITE );
+		}
+	}
+};
+
+class Session
+{
+public:
 	const Tiles& tiles;
 	Level& level;
 	const Settings& settings;
@@ -698,12 +1165,32 @@ public:
 	Camera2D gameplayCamera;
 
 	Vector2Int heroTile;
-	Vector2 heroPosition;
+	// Where the level file puts the exit, open or closed; { -1, -1 } if it has none
+	Vector2Int exitCell;
+	Vector2Fixed heroPosition;
+	// Where the hero was one tick earlier, to draw it between ticks
+	Vector2Fixed previousHeroPosition;
 	unsigned int heroMoveFlags;
 
 	Pathfinder pathfinder;
+	// Counters of the latest path searches, search i at i % pathfinderHistorySize
+	static const int pathfinderHistorySize = 64;
+	array<PathfinderStats, pathfinderHistorySize> pathfinderHistory;
+	int pathSearches = 0;
+	SpriteBatch spriteBatch;
+	LevelRenderer levelRenderer;
 	vector<PathPoint> currentPath;
-	float progress = 0;
+	// What currentPath was searched from, recorded for rewinding
+	RewindBuffer::PathInput pathInput;
+	// The last paths followed and what they were searched from, so that seeking back and forth over path changes copies them
+	// instead of searching again
+	static const int cachedPathCount = 8;
+	array<RewindBuffer::PathInput, cachedPathCount> cachedPathInputs;
+	array<vector<PathPoint>, cachedPathCount> cachedPaths;
+	int nextCachedPath = 0;
+	Fixed progress;
+	// Path point the hero last passed; progress only grows, so each tick resumes the search from there
+	int pathSegment = 0;
 
 	int totalCoins = 0;
 	int collectedCoins = 0;
@@ -713,23 +1200,73 @@ public:
 
 	vector<Enemy> enemies;
 
-	float totalTime = 0;
-
-	Session( const Tiles& _tiles, Level& _level, const Settings& _settings ) : tiles( _tiles ), level( _level ), settings( _settings ), pathfinder( tiles, level )
+	// Enemy indices binned by the top-left cell of their path, to cull them without visiting every enemy
+	static const int enemyBinSize = 16;
+	Vector2Int enemyBinsPerSide;
+	vector<vector<int>> enemyBins;
+	bool enemyBinsDirty = true;
+
+	// Simulated time, in ticks of simulationTicksPerSecond
+	int simulationTicks = 0;
+	// Real time not simulated yet, less than a tick after each step
+	float tickAccumulator = 0;
+
+	Ghost::Recorder ghostRecorder;
+	// Best run on this level, replayed next to the hero
+	optional<Ghost::Playback> ghost;
+
+	// The last minute of play, for rewinding
+	static const int rewindSeconds = 60;
+	RewindBuffer rewindBuffer{ rewindSeconds * simulationTicksPerSecond };
+	// Enemy progress when the rewind buffer was reset; enemies all walk the same distance per tick, so this and the distance
+	// walked since give every enemy's progress at any tick
+	vector<Fixed> rewindEnemyProgress;
+	int64_t enemyDistance = 0;
+	// Cells changed by the tick being simulated, usually at most a coin and the exit
+	vector<RewindBuffer::CellChange> tickCellChanges;
+	float rewindAccumulator = 0;
+	// Rewound runs do not count as best times
+	bool rewound = false;
+
+	// Robots sharing the level with the hero, for load testing; they are not part of the rewind state, so the session does not
+	// rewind while they run
+	unique_ptr<Crowd> crowd;
+	static const int crowdTargets = 8;
+
+	Session( const Tiles& _tiles, Level& _level, const Settings& _settings ) : tiles( _tiles ), level( _level ), settings( _settings ), pathfinder( level ), levelRenderer( tiles, level, spriteBatch )
 	{
 		memset( &gameplayCamera, 0, sizeof( Camera2D ) );
 
 		heroTile = level.findFirstCell( Tiles::getHero() );
 		level.setCellAt( heroTile, Tiles::getEmpty() );
-		heroPosition = Vector2IntToFloat( heroTile );
+		heroPosition = Vector2FixedFromInt( heroTile );
+		previousHeroPosition = heroPosition;
 
 		totalCoins = level.findAllCells( Tiles::getCoin() ).size();
+		exitCell = level.findFirstCell( Tiles::getClosedExit() );
 
 		createEnemies();
+
+		// Keep the play loop free of allocations: collecting every coin and opening the exit, ten minutes of ghost, and paths of
+		// up to 8 points per cell of width and height, while the longest on any bundled level has under 3. goTo keeps the
+		// capacity of currentPath, so a longer path on a bigger level only grows it once.
+		level.reserveChangedCells( totalCoins + 1 );
+		ghostRecorder.reserve( 10 * 60 );
+		currentPath.reserve( 8 * ( level.getSize().x + level.getSize().y ) );
+		for ( vector<PathPoint>& path : cachedPaths )
+		{
+			path.reserve( currentPath.capacity() );
+		}
+		tickCellChanges.reserve( 2 );
+
+		resetRewind();
 	}
 
-	void step()
+	void step( const bool rewinding )
 	{
+		PROFILE_SCOPE( "Session::step" );
+		ALLOCATION_SCOPE( "Session::step" );
+
 		if ( ImGui::BeginDevMenuBar() )
 		{
 			if ( ImGui::BeginMenu( "Session" ) )
@@ -744,13 +1281,23 @@ public:
 					failed = true;
 					return;
 				}
+				ImGui::Separator();
+				for ( const int agents : { 1000, 10000, 50000 } )
+				{
+					if ( ImGui::MenuItem( ( "Crowd of " + to_string( agents ) ).c_str() ) )
+					{
+						startCrowd( agents );
+					}
+				}
+				if ( ImGui::MenuItem( "Stop Crowd", nullptr, false, crowd != nullptr ) )
+				{
+					crowd.reset();
+				}
 				ImGui::EndMenu();
 			}
 			ImGui::EndMainMenuBar();
 		}
 
-		totalTime += GetFrameTime();
-
 		// Set camera
 		gameplayCamera.target = Vector2{ float( level.getSize().x ) / 2, float( level.getSize().y ) / 2 };
 		gameplayCamera.offset = Vector2{ float( GetScreenWidth() ) / 2, float( GetScreenHeight() ) / 2 };
@@ -759,144 +1306,450 @@ public:
 		// Find new path
 		if ( IsMouseButtonPressed( MOUSE_LEFT_BUTTON ) && !ImGui::GetIO().WantCaptureMouse )
 		{
-			const Vector2 worldPosition = GetScreenToWorld2D( GetMousePosition(), settings.debug.enableDebugCamera ? settings.debug.debugCamera : gameplayCamera );
-			const Vector2Int currentPosition{ int( heroPosition.x ), int( heroPosition.y ) };
+			const Vector2 worldPosition = GetScreenToWorld2D( GetMousePosition(), getActiveCamera() );
+			const Vector2Int currentPosition = Vector2FixedFloor( heroPosition );
 			const Vector2Int destination{ int( worldPosition.x ), int( worldPosition.y ) };
 
-			if ( !( destination.x < 0 || destination.x >= level.getSize().x || destination.y < 0 || destination.y >= level.getSize().y ) )
+			if ( Vector2IntInBounds( destination, level.getSize() ) )
 			{
-				currentPath = pathfinder.goTo( currentPosition, destination );
-				progress = 0;
+				pathfinder.goTo( currentPosition, destination, currentPath, settings.debug.pathStats || settings.debug.pathHeatmap );
+				pathInput = RewindBuffer::PathInput{ simulationTicks, currentPosition, destination };
+				cachePath();
+				pathfinderHistory[ pathSearches % pathfinderHistorySize ] = pathfinder.getLastStats();
+				++pathSearches;
+				progress = Fixed();
+				pathSegment = 0;
 				heroMoveFlags = MoveFlags_None;
 			}
 		}
 
+		if ( rewinding && !crowd )
+		{
+			rewindAccumulator += GetFrameTime() * settings.gameplay.rewindSpeed * simulationTicksPerSecond;
+			const int ticks = int( rewindAccumulator );
+			rewindAccumulator -= ticks;
+			rewind( ticks );
+			return;
+		}
+		rewindAccumulator = 0;
+
+		// Simulate the elapsed real time in fixed ticks; after a long stall only a quarter of a second is caught up
+		const float tickDuration = 1.0f / simulationTicksPerSecond;
+		tickAccumulator = std::min( tickAccumulator + GetFrameTime(), 0.25f );
+		while ( tickAccumulator >= tickDuration && !completed && !failed )
+		{
+			tickAccumulator -= tickDuration;
+			simulateTick();
+		}
+	}
+
+	// Seconds of simulated time, derived from the tick count so that it is exact
+	float getTotalTime() const
+	{
+		return float( simulationTicks ) / simulationTicksPerSecond;
+	}
+
+	// Advances the game by one tick, in fixed point only, so that the same inputs give the same run everywhere
+	void simulateTick()
+	{
+		const int ticksPerGhostFrame = simulationTicksPerSecond / int( Ghost::ticksPerSecond );
+		if ( simulationTicks % ticksPerGhostFrame == 0 )
+		{
+			ghostRecorder.record( heroPosition, heroMoveFlags | ( currentPath.empty() ? 0 : Ghost::movingFlag ) );
+		}
+		++simulationTicks;
+		previousHeroPosition = heroPosition;
+		tickCellChanges.clear();
+
 		// Move hero
 		if ( !currentPath.empty() )
 		{
-			progress += settings.gameplay.heroStepsPerSecond * GetFrameTime();
+			progress += getDistancePerTick( settings.gameplay.heroStepsPerSecond );
 			if ( progress >= currentPath.back().progress )
 			{
 				heroPosition = currentPath.back().coords;
 				currentPath.clear();
-				progress = 0;
+				pathInput = RewindBuffer::PathInput();
+				progress = Fixed();
+				pathSegment = 0;
 				heroMoveFlags = MoveFlags_None;
 			} else
 			{
-				for ( int i = 0; i < currentPath.size() - 1; ++i )
+				while ( progress >= currentPath.at( pathSegment + 1 ).progress )
 				{
-					if ( progress >= currentPath.at( i ).progress && progress < currentPath.at( i + 1 ).progress )
-					{
-						const float blend = ( progress - currentPath.at( i ).progress ) / ( currentPath.at( i + 1 ).progress - currentPath.at( i ).progress );
-						heroPosition = Vector2Lerp( currentPath.at( i ).coords, currentPath.at( i + 1 ).coords, blend );
-						heroMoveFlags = currentPath.at( i + 1 ).moveFlags;
-					}
+					++pathSegment;
 				}
+
+				const PathPoint& from = currentPath.at( pathSegment );
+				const PathPoint& to = currentPath.at( pathSegment + 1 );
+				const Fixed blend = ( progress - from.progress ) / ( to.progress - from.progress );
+				heroPosition = Vector2FixedLerp( from.coords, to.coords, blend );
+				heroMoveFlags = to.moveFlags;
 			}
 		}
 
+		if ( crowd )
+		{
+			crowd->update( getDistancePerTick( settings.gameplay.heroStepsPerSecond ) );
+		}
+
 		// Move enemies
-		updateEnemies( GetFrameTime() );
+		const Fixed enemyTickDistance = getDistancePerTick( settings.gameplay.enemySpeed );
+		updateEnemies( enemyTickDistance );
+		enemyDistance += enemyTickDistance.raw;
 
 		// Check collisions
 		{
-			const Vector2 heroCenter{ heroPosition.x + 0.5f, heroPosition.y + 0.5f };
-			const Vector2Int touchedTile{ int( heroCenter.x ), int( heroCenter.y ) };
-
-			if ( touchedTile.x < 0 || touchedTile.x >= level.getSize().x || touchedTile.y < 0 || touchedTile.y >= level.getSize().y )
+			const HeroContacts contacts = findHeroContacts( level, heroPosition, enemies, Fixed::fromFloat( settings.gameplay.coinRadius ), Fixed::fromFloat( settings.gameplay.enemyRadius ) );
+			if ( contacts.outOfLevel || contacts.enemy )
 			{
 				failed = true;
-			} else
+			}
+			if ( contacts.coin )
+			{
+				setCellDuringTick( contacts.touchedTile, Tiles::getEmpty() );
+				++collectedCoins;
+			}
+			if ( contacts.openExit )
 			{
-				const Vector2 touchedTileCenter{ float( touchedTile.x ) + 0.5f, float( touchedTile.y ) + 0.5f };
-				const float distance = Vector2Distance( heroCenter, touchedTileCenter );
+				completed = true;
+			}
+		}
+
+		// Open exit
+		if ( collectedCoins == totalCoins && exitCell.x != -1 && level.getCellAt( exitCell ) == Tiles::getClosedExit() )
+		{
+			setCellDuringTick( exitCell, Tiles::getOpenExit() );
+		}
 
-				if ( level.getCellAt( touchedTile ) == Tiles::getCoin() && distance <= settings.gameplay.coinRadius )
+		rewindBuffer.push( getRewindState(), tickCellChanges.data(), int( tickCellChanges.size() ) );
+	}
+
+	// Steps back the given number of ticks, as far as the buffer goes; the hero resumes the path it was following then
+	void rewind( const int ticks )
+	{
+		const RewindBuffer::State state = rewindBuffer.rewindTo( simulationTicks - ticks, [ this ]( const RewindBuffer::CellChange& change )
+			{
+				level.setCellAt( Vector2IntFromIndex( change.index, level.getSize().x ), change.oldTile );
+				if ( change.oldTile == Tiles::getCoin() )
 				{
-					level.setCellAt( touchedTile, Tiles::getEmpty() );
-					++collectedCoins;
+					--collectedCoins;
 				}
+			} );
+		rewound = rewound || state.tick != simulationTicks;
+
+		simulationTicks = state.tick;
+		heroPosition = state.heroPosition;
+		previousHeroPosition = heroPosition;
+		heroMoveFlags = state.heroMoveFlags;
+		restorePath( state.path );
+		tickAccumulator = 0;
+
+		enemyDistance = state.enemyDistance;
+		for ( int i = 0; i < enemies.size(); ++i )
+		{
+			Enemy& enemy = enemies[ i ];
+			const Fixed loopLength = getEnemyLoopLength( enemy );
+			enemy.progress = rewindEnemyProgress[ i ];
+			::updateEnemy( enemy, loopLength == Fixed() ? Fixed() : Fixed::fromRaw( enemyDistance % loopLength.raw ) );
+			enemy.previousPosition = enemy.position;
+		}
+	}
+
+	// Applies cells edited in the level file since it was loaded, touching only the derived state of those cells
+	void applyLevelEdit( const Level& previousSource, const Level& newSource, const vector<Vector2Int>& changedCells )
+	{
+		// Everything below looks cells up in this set, so the work grows with the edit rather than with the level
+		unordered_set<CellKey> editedCells;
+		bool blueprintsEdited = false;
+		for ( const Vector2Int& cellPosition : changedCells )
+		{
+			editedCells.insert( CellKey( cellPosition ) );
+			blueprintsEdited |= Tiles::isEnemyBlueprint( previousSource.getCellAt( cellPosition ) );
+		}
+
+		// Enemies of edited blueprints go in a single pass before new ones are created
+		if ( blueprintsEdited )
+		{
+			enemies.erase( std::remove_if( enemies.begin(), enemies.end(), [ &editedCells ]( const Enemy& enemy ) { return editedCells.count( CellKey( enemy.blueprintCell ) ) > 0; } ), enemies.end() );
+			enemyBinsDirty = true;
+		}
+
+		for ( const Vector2Int& cellPosition : changedCells )
+		{
+			const int oldTile = previousSource.getCellAt( cellPosition );
+			const int newTile = newSource.getCellAt( cellPosition );
+			const int liveTile = level.getCellAt( cellPosition );
 
-				if ( level.getCellAt( touchedTile ) == Tiles::getOpenExit() && distance <= 0.1f )
+			// Exit
+			if ( newTile == Tiles::getClosedExit() )
+			{
+				exitCell = cellPosition;
+			} else if ( cellPosition == exitCell )
+			{
+				exitCell = Vector2Int{ -1, -1 };
+			}
+
+			// Coins
+			if ( oldTile == Tiles::getCoin() )
+			{
+				--totalCoins;
+				if ( liveTile != Tiles::getCoin() )
 				{
-					completed = true;
+					--collectedCoins;
 				}
+			}
+			if ( newTile == Tiles::getCoin() )
+			{
+				++totalCoins;
+			}
 
-				for ( const Enemy& enemy : enemies )
+			// Live cell
+			if ( Tiles::isEnemyBlueprint( newTile ) )
+			{
+				updateEnemy( createEnemy( cellPosition, newTile ), Fixed() );
+			} else if ( newTile == Tiles::getHero() )
+			{
+				level.setCellAt( cellPosition, Tiles::getEmpty() );
+			} else if ( newTile == Tiles::getClosedExit() && liveTile == Tiles::getOpenExit() )
+			{
+				// Decided below, once every coin count is updated
+			} else
+			{
+				level.setCellAt( cellPosition, newTile );
+			}
+		}
+
+		// The exit only stays open if the edit, wherever it added coins, left none to collect
+		if ( collectedCoins != totalCoins && exitCell.x != -1 && level.getCellAt( exitCell ) == Tiles::getOpenExit() )
+		{
+			level.setCellAt( exitCell, Tiles::getClosedExit() );
+		}
+
+		// Stop the hero on its current cell if the path crosses the edit
+		const bool pathInvalidated = std::any_of( currentPath.begin(), currentPath.end(), [ &editedCells ]( const PathPoint& point ) { return editedCells.count( CellKey( Vector2FixedFloor( point.coords ) ) ) > 0; } );
+		if ( pathInvalidated )
+		{
+			heroPosition = Vector2FixedFromInt( Vector2FixedFloor( getCellCenter( Vector2IntZero() ) + heroPosition ) );
+			previousHeroPosition = heroPosition;
+			currentPath.clear();
+			pathInput = RewindBuffer::PathInput();
+			progress = Fixed();
+			pathSegment = 0;
+			heroMoveFlags = MoveFlags_None;
+		}
+
+		// Earlier ticks were played on the level before the edit
+		resetRewind();
+		if ( crowd )
+		{
+			crowd->invalidate( editedCells );
+		}
+	}
+
+	void startCrowd( const int agents )
+	{
+		crowd = make_unique<Crowd>( level, pathfinder, Vector2FixedFloor( heroPosition ), agents, crowdTargets, 1, getJobLaunchPolicy() );
+	}
+
+	const Camera2D& getActiveCamera() const
+	{
+		return settings.debug.enableDebugCamera ? settings.debug.debugCamera : gameplayCamera;
+	}
+
+	// Updates cached render data; must be called before render, outside of BeginMode2D
+	void prepareRender()
+	{
+		levelRenderer.update( getActiveCamera() );
+	}
+
+	void render()
+	{
+		PROFILE_SCOPE( "Session::render" );
+		ALLOCATION_SCOPE( "Session::render" );
+
+		Vector2Int visibleMin;
+		Vector2Int visibleMax;
+		getVisibleCells( getActiveCamera(), visibleMin, visibleMax );
+
+		// Moving things are drawn between their last two ticks
+		const float tickFraction = std::min( tickAccumulator * simulationTicksPerSecond, 1.0f );
+		const float renderTime = getTotalTime() + tickAccumulator;
+
+		// Draw enemies
+		if ( enemyBinsDirty )
+		{
+			updateEnemyBins();
+		}
+		if ( visibleMin.x < visibleMax.x && visibleMin.y < visibleMax.y )
+		{
+			// Enemy paths are shorter than a bin, so enemies binned up to one bin above or to the left may reach into view
+			const int firstBinX = std::max( 0, visibleMin.x / enemyBinSize - 1 );
+			const int firstBinY = std::max( 0, visibleMin.y / enemyBinSize - 1 );
+			for ( int i = firstBinY; i <= ( visibleMax.y - 1 ) / enemyBinSize; ++i )
+			{
+				for ( int j = firstBinX; j <= ( visibleMax.x - 1 ) / enemyBinSize; ++j )
 				{
-					if ( Vector2Distance( heroCenter, enemy.position ) <= settings.gameplay.enemyRadius )
+					for ( const int enemyIndex : enemyBins.at( i * enemyBinsPerSide.x + j ) )
 					{
-						failed = true;
+						const Vector2 position = getEnemyRenderPosition( enemies.at( enemyIndex ), tickFraction );
+						if ( position.x + 0.5f < visibleMin.x || position.x - 0.5f > visibleMax.x || position.y + 0.5f < visibleMin.y || position.y - 0.5f > visibleMax.y )
+						{
+							continue;
+						}
+						levelRenderer.drawTile( Tiles::getEnemy(), Rectangle{ position.x - 0.5f, position.y - 0.5f, 1, 1 }, WHITE );
 					}
 				}
 			}
 		}
 
-		// Open exit
-		if ( collectedCoins == totalCoins )
+		// Draw world
+		levelRenderer.render( visibleMin, visibleMax );
+
+		// Draw crowd, with the animations spread out so that the robots do not move in lockstep
+		if ( crowd )
 		{
-			const Vector2Int doorPosition = level.findFirstCell( Tiles::getClosedExit() );
-			if ( doorPosition.x != -1 && doorPosition.y != -1 )
+			const float extraSteps = tickFraction * getDistancePerTick( settings.gameplay.heroStepsPerSecond ).toFloat();
+			const vector<Crowd::Agent>& agents = crowd->getAgents();
+			for ( int i = 0; i < agents.size(); ++i )
 			{
-				level.setCellAt( doorPosition, Tiles::getOpenExit() );
+				const Vector2 position = crowd->getAgentPosition( agents[ i ], extraSteps );
+				if ( position.x + 1 < visibleMin.x || position.x > visibleMax.x || position.y + 1 < visibleMin.y || position.y > visibleMax.y )
+				{
+					continue;
+				}
+				const vector<int>& animation = getHeroAnimation( agents[ i ].move != FlowField::noMove, crowd->getAgentMoveFlags( agents[ i ] ) );
+				const int frame = ( int( renderTime * settings.gameplay.heroAnimationFps ) + i ) % animation.size();
+				levelRenderer.drawTile( animation.at( frame ), Rectangle{ position.x, position.y, 1, 1 }, Color{ 170, 200, 255, 255 } );
 			}
 		}
+
+		// Draw ghost
+		if ( ghost.has_value() && !ghost->isEmpty() )
+		{
+			const Ghost::Frame ghostFrame = ghost->getFrameAt( renderTime );
+			const vector<int>& animation = getHeroAnimation( ghostFrame.flags & Ghost::movingFlag, ghostFrame.flags );
+			const int frame = int( renderTime * settings.gameplay.heroAnimationFps ) % animation.size();
+			levelRenderer.drawTile( animation.at( frame ), Rectangle{ ghostFrame.position.x, ghostFrame.position.y, 1, 1 }, Fade( WHITE, 0.4f ) );
+		}
+
+		// Draw hero
+		{
+			const vector<int>& animation = getHeroAnimation( !currentPath.empty(), heroMoveFlags );
+			const int frame = int( renderTime * settings.gameplay.heroAnimationFps ) % animation.size();
+			const Vector2 position = Vector2Lerp( Vector2FixedToFloat( previousHeroPosition ), Vector2FixedToFloat( heroPosition ), tickFraction );
+			levelRenderer.drawTile( animation.at( frame ), Rectangle{ position.x, position.y, 1, 1 }, WHITE );
+		}
+
+		spriteBatch.flush();
 	}
 
-	void render()
+private:
+	void resetRewind()
 	{
-		// Draw enemies
+		rewindEnemyProgress.clear();
 		for ( const Enemy& enemy : enemies )
 		{
-			DrawTexturePro( tiles.getTexture(), tiles.getRectangleForTile( Tiles::getEnemy() ), Rectangle{ enemy.position.x - 0.5f, enemy.position.y - 0.5f, 1, 1 }, Vector2{ 0,0 }, 0, WHITE );
+			rewindEnemyProgress.push_back( enemy.progress );
 		}
+		enemyDistance = 0;
+		// Each coin is collected at most once between two rewinds, and the exit opened once
+		rewindBuffer.reset( getRewindState(), totalCoins + 1 );
+		// Walls may have changed, so the same input could now find another path
+		cachedPathInputs.fill( RewindBuffer::PathInput() );
+	}
 
-		// Draw world
-		for ( int i = 0; i < level.getSize().y; ++i )
+	RewindBuffer::State getRewindState() const
+	{
+		RewindBuffer::State state;
+		state.tick = simulationTicks;
+		state.heroPosition = heroPosition;
+		state.heroMoveFlags = heroMoveFlags;
+		state.enemyDistance = enemyDistance;
+		state.path = pathInput;
+		return state;
+	}
+
+	// Puts the hero back on the path it followed at simulationTicks. Ticks never change walls, so searching again from the
+	// same input finds the same path, and the hero walks the same distance every tick, which gives the progress along it.
+	void restorePath( const RewindBuffer::PathInput& path )
+	{
+		if ( path.startTick < 0 )
 		{
-			for ( int j = 0; j < level.getSize().x; ++j )
+			currentPath.clear();
+		} else if ( currentPath.empty() || !RewindBuffer::isSamePath( path, pathInput ) )
+		{
+			const auto cached = std::find_if( cachedPathInputs.begin(), cachedPathInputs.end(), [ &path ]( const RewindBuffer::PathInput& input ) { return RewindBuffer::isSamePath( input, path ); } );
+			if ( cached != cachedPathInputs.end() )
 			{
-				const int cell = level.getCellAt( Vector2Int{ j, i } );
-				if ( cell != Tiles::getEmpty() )
-				{
-					DrawTexturePro( tiles.getTexture(), tiles.getRectangleForTile( cell ), Rectangle{ float( j ), float( i ), 1, 1 }, Vector2{ 0, 0 }, 0, WHITE );
-				}
+				const vector<PathPoint>& cachedPath = cachedPaths[ cached - cachedPathInputs.begin() ];
+				currentPath.assign( cachedPath.begin(), cachedPath.end() );
+			} else
+			{
+				pathfinder.goTo( path.start, path.destination, currentPath );
+				pathInput = path;
+				cachePath();
 			}
 		}
+		pathInput = path;
 
-		// Draw hero
+		progress = Fixed::fromRaw( int64_t( simulationTicks - path.startTick ) * getDistancePerTick( settings.gameplay.heroStepsPerSecond ).raw );
+		pathSegment = 0;
+		if ( currentPath.empty() || progress >= currentPath.back().progress )
+		{
+			currentPath.clear();
+			pathInput = RewindBuffer::PathInput();
+			progress = Fixed();
+			return;
+		}
+		while ( progress >= currentPath.at( pathSegment + 1 ).progress )
 		{
-			const vector<int>* animation;
+			++pathSegment;
+		}
+	}
 
-			if ( currentPath.empty() )
+	// Sets a cell from the simulation, so that rewinding can restore it; when the rewind buffer cannot hold all the changes of a
+	// tick, it starts its history over at that tick
+	void setCellDuringTick( const Vector2Int& position, const int tile )
+	{
+		tickCellChanges.push_back( RewindBuffer::CellChange{ Vector2IntToIndex( position, level.getSize().x ), level.getCellAt( position ), tile } );
+		level.setCellAt( position, tile );
+	}
+
+	// Keeps currentPath and pathInput among the last paths, replacing the oldest
+	void cachePath()
+	{
+		cachedPathInputs[ nextCachedPath ] = pathInput;
+		cachedPaths[ nextCachedPath ].assign( currentPath.begin(), currentPath.end() );
+		nextCachedPath = ( nextCachedPath + 1 ) % cachedPathCount;
+	}
+
+	static const vector<int>& getHeroAnimation( const bool moving, const unsigned int moveFlags )
+	{
+		if ( !moving )
+		{
+			return Tiles::getHeroIdleAnimation();
+		} else if ( moveFlags & MoveFlags_JumpAnimation )
+		{
+			if ( moveFlags & MoveFlags_MirroredAnimation )
 			{
-				animation = &Tiles::getHeroIdleAnimation();
-			} else if ( heroMoveFlags & MoveFlags_JumpAnimation )
+				return Tiles::getHeroJumpMirroredAnimation();
+			} else
 			{
-				if ( heroMoveFlags & MoveFlags_MirroredAnimation )
-				{
-					animation = &Tiles::getHeroJumpMirroredAnimation();
-				} else
-				{
-					animation = &Tiles::getHeroJumpAnimation();
-				}
+				return Tiles::getHeroJumpAnimation();
+			}
+		} else
+		{
+			if ( moveFlags & MoveFlags_MirroredAnimation )
+			{
+				return Tiles::getHeroRunMirroredAnimation();
 			} else
 			{
-				if ( heroMoveFlags & MoveFlags_MirroredAnimation )
-				{
-					animation = &Tiles::getHeroRunMirroredAnimation();
-				} else
-				{
-					animation = &Tiles::getHeroRunAnimation();
-				}
+				return Tiles::getHeroRunAnimation();
 			}
-
-			const int frame = int( totalTime * settings.gameplay.heroAnimationFps ) % animation->size();
-			DrawTexturePro( tiles.getTexture(), tiles.getRectangleForTile( animation->at( frame ) ), Rectangle{ heroPosition.x, heroPosition.y, 1, 1 }, Vector2{ 0, 0 }, 0, WHITE );
 		}
 	}
 
-private:
 
 	void createEnemies()
 	{
@@ -908,64 +1761,94 @@ private:
 				const int cell = level.getCellAt( cellPosition );
 				if ( Tiles::isEnemyBlueprint( cell ) )
 				{
-					int pathLength;
-					bool horizontal;
-					bool startsAtEnd;
-					Tiles::getEnemyBlueprintProperties( cell, pathLength, horizontal, startsAtEnd );
-
-					Enemy enemy;
-					enemy.startCell = cellPosition;
-					if ( horizontal )
-					{
-						enemy.endCell = Vector2Int{ cellPosition.x + pathLength - 1, cellPosition.y };
-					} else
-					{
-						enemy.endCell = Vector2Int{ cellPosition.x, cellPosition.y - ( pathLength - 1 ) };
-					}
-					if ( startsAtEnd )
-					{
-						std::swap( enemy.startCell, enemy.endCell );
-					}
-					enemy.progress = 0;
-
-					enemies.push_back( enemy );
-					level.setCellAt( cellPosition, Tiles::getEmpty() );
+					createEnemy( cellPosition, cell );
 				}
 			}
 		}
 
-		updateEnemies( 0 );
+		updateEnemies( Fixed() );
 	}
 
-	void updateEnemies( const float deltaTime )
+	Enemy& createEnemy( const Vector2Int& cellPosition, const int blueprint )
 	{
-		for ( Enemy& enemy : enemies )
+		enemies.push_back( createEnemyFromBlueprint( cellPosition, blueprint ) );
+		enemyBinsDirty = true;
+		level.setCellAt( cellPosition, Tiles::getEmpty() );
+		return enemies.back();
+	}
+
+	void updateEnemyBins()
+	{
+		enemyBinsPerSide = Vector2Int{ ( level.getSize().x + enemyBinSize - 1 ) / enemyBinSize, ( level.getSize().y + enemyBinSize - 1 ) / enemyBinSize };
+		enemyBins.assign( enemyBinsPerSide.x * enemyBinsPerSide.y, vector<int>() );
+
+		for ( int i = 0; i < enemies.size(); ++i )
 		{
-			const Vector2 startPosition = Vector2Add( Vector2IntToFloat( enemy.startCell ), Vector2{ 0.5f, 0.5f } );
-			const Vector2 endPosition = Vector2Add( Vector2IntToFloat( enemy.endCell ), Vector2{ 0.5f, 0.5f } );
-			const float halfLength = Vector2Distance( startPosition, endPosition );
-			const float fullLength = halfLength * 2;
+			const Enemy& enemy = enemies.at( i );
+			const Vector2Int pathMin{ std::clamp( std::min( enemy.startCell.x, enemy.endCell.x ), 0, level.getSize().x - 1 ), std::clamp( std::min( enemy.startCell.y, enemy.endCell.y ), 0, level.getSize().y - 1 ) };
+			enemyBins.at( ( pathMin.y / enemyBinSize ) * enemyBinsPerSide.x + pathMin.x / enemyBinSize ).push_back( i );
+		}
 
-			enemy.progress += settings.gameplay.enemySpeed * deltaTime;
-			enemy.progress = fmod( enemy.progress, fullLength );
+		enemyBinsDirty = false;
+	}
 
-			if ( enemy.progress < halfLength )
-			{
-				enemy.position = Vector2Lerp( startPosition, endPosition, enemy.progress / halfLength );
-			} else
-			{
-				enemy.position = Vector2Lerp( endPosition, startPosition, ( enemy.progress - halfLength ) / halfLength );
-			}
+	// Returns the range of level cells seen through the camera, max excluded
+	void getVisibleCells( const Camera2D& camera, Vector2Int& visibleMin, Vector2Int& visibleMax ) const
+	{
+		const array<Vector2, 4> corners{
+			GetScreenToWorld2D( Vector2{ 0, 0 }, camera ),
+			GetScreenToWorld2D( Vector2{ float( GetScreenWidth() ), 0 }, camera ),
+			GetScreenToWorld2D( Vector2{ 0, float( GetScreenHeight() ) }, camera ),
+			GetScreenToWorld2D( Vector2{ float( GetScreenWidth() ), float( GetScreenHeight() ) }, camera ),
+		};
+
+		Vector2 worldMin = corners.front();
+		Vector2 worldMax = corners.front();
+		for ( const Vector2& corner : corners )
+		{
+			worldMin = Vector2{ std::min( worldMin.x, corner.x ), std::min( worldMin.y, corner.y ) };
+			worldMax = Vector2{ std::max( worldMax.x, corner.x ), std::max( worldMax.y, corner.y ) };
+		}
+
+		visibleMin.x = std::clamp( int( floorf( worldMin.x ) ), 0, level.getSize().x );
+		visibleMin.y = std::clamp( int( floorf( worldMin.y ) ), 0, level.getSize().y );
+		visibleMax.x = std::clamp( int( ceilf( worldMax.x ) ), 0, level.getSize().x );
+		visibleMax.y = std::clamp( int( ceilf( worldMax.y ) ), 0, level.getSize().y );
+	}
+
+	void updateEnemies( const Fixed& distance )
+	{
+		for ( Enemy& enemy : enemies )
+		{
+			updateEnemy( enemy, distance );
 		}
 	}
+
+	void updateEnemy( Enemy& enemy, const Fixed& distance )
+	{
+		::updateEnemy( enemy, distance );
+	}
 };
 
 struct BestTime
 {
 	int level;
 	float time;
+	// Base64 of the Ghost::Recorder data for the run
+	std::string ghost;
 
-	NLOHMANN_DEFINE_TYPE_INTRUSIVE(BestTime, level, time);
+	friend void to_json( nlohmann::json& json, const BestTime& bestTime )
+	{
+		json = nlohmann::json{ { "level", bestTime.level }, { "time", bestTime.time }, { "ghost", bestTime.ghost } };
+	}
+
+	// Savegames written before ghosts were recorded have no ghost field
+	friend void from_json( const nlohmann::json& json, BestTime& bestTime )
+	{
+		json.at( "level" ).get_to( bestTime.level );
+		json.at( "time" ).get_to( bestTime.time );
+		bestTime.ghost = json.value( "ghost", std::string() );
+	}
 };
 
 struct Savegame
@@ -975,6 +1858,185 @@ struct Savegame
 	NLOHMANN_DEFINE_TYPE_INTRUSIVE(Savegame, bestTimes);
 };
 
+// Keeps the savegame in memory after a single parse; changes are written by a background thread through a temporary file and a rename
+class SavegameStore
+{
+public:
+	SavegameStore( const std::filesystem::path& _path ) : path( _path )
+	{
+		if ( std::filesystem::exists( path ) )
+		{
+			try
+			{
+				std::ifstream stream( path );
+				nlohmann::json json;
+				stream >> json;
+				const Savegame savegame = json;
+				for ( const BestTime& bestTime : savegame.bestTimes )
+				{
+					if ( bestTime.level >= 0 )
+					{
+						slotFor( bestTime.level ) = Record{ bestTime.time, Ghost::fromBase64( bestTime.ghost ) };
+					}
+				}
+			} catch ( const nlohmann::json::exception& e )
+			{
+				TraceLog( LOG_WARNING, "Ignoring unreadable savegame %s: %s", path.string().c_str(), e.what() );
+			}
+		}
+
+#if !__WEB
+		writer = std::thread( &SavegameStore::writeLoop, this );
+#endif
+	}
+
+	~SavegameStore()
+	{
+#if !__WEB
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			stopRequested = true;
+		}
+		wakeWriter.notify_one();
+		writer.join();
+#endif
+	}
+
+	SavegameStore( const SavegameStore& ) = delete;
+	SavegameStore& operator=( const SavegameStore& ) = delete;
+
+	std::optional<float> getBestTime( const int level ) const
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		if ( level < records.size() && records.at( level ).has_value() )
+		{
+			return records.at( level )->time;
+		}
+		return std::nullopt;
+	}
+
+	// Encoded ghost of the best run, or an empty string
+	std::string getGhost( const int level ) const
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		if ( level < records.size() && records.at( level ).has_value() )
+		{
+			return records.at( level )->ghost;
+		}
+		return std::string();
+	}
+
+	void setBestTime( const int level, const float time, const std::string& ghost )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			slotFor( level ) = Record{ time, ghost };
+			dirty = true;
+		}
+
+#if __WEB
+		write( snapshot() );
+#else
+		wakeWriter.notify_one();
+#endif
+	}
+
+private:
+	// Lets changes that come in quick succession share a single write
+	static constexpr std::chrono::milliseconds batchDelay{ 250 };
+
+	struct Record
+	{
+		float time;
+		std::string ghost;
+	};
+
+	const std::filesystem::path path;
+	std::vector<std::optional<Record>> records;
+	mutable std::mutex mutex;
+	std::condition_variable wakeWriter;
+	bool dirty = false;
+	bool stopRequested = false;
+	std::thread writer;
+
+	std::optional<Record>& slotFor( const int level )
+	{
+		if ( level >= records.size() )
+		{
+			records.resize( level + 1 );
+		}
+		return records.at( level );
+	}
+
+	Savegame snapshot()
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		dirty = false;
+
+		Savegame savegame;
+		for ( int level = 0; level < records.size(); ++level )
+		{
+			if ( records.at( level ).has_value() )
+			{
+				savegame.bestTimes.push_back( BestTime{ level, records.at( level )->time, Ghost::toBase64( records.at( level )->ghost ) } );
+			}
+		}
+		return savegame;
+	}
+
+	void write( const Savegame& savegame ) const
+	{
+		std::error_code ec;
+		std::filesystem::create_directories( path.parent_path(), ec );
+
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream stream( temporaryPath, std::ios::trunc );
+			nlohmann::json json;
+			json = savegame;
+			stream << json;
+			stream.flush();
+			if ( !stream )
+			{
+				TraceLog( LOG_WARNING, "Cannot write savegame %s", temporaryPath.string().c_str() );
+				return;
+			}
+		}
+
+		std::filesystem::rename( temporaryPath, path, ec );
+		if ( ec )
+		{
+			TraceLog( LOG_WARNING, "Cannot replace savegame %s: %s", path.string().c_str(), ec.message().c_str() );
+		}
+	}
+
+	void writeLoop()
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		while ( true )
+		{
+			wakeWriter.wait( lock, [ this ] { return dirty || stopRequested; } );
+			if ( !stopRequested )
+			{
+				wakeWriter.wait_for( lock, batchDelay, [ this ] { return stopRequested; } );
+			}
+
+			if ( dirty )
+			{
+				lock.unlock();
+				write( snapshot() );
+				lock.lock();
+			}
+
+			if ( stopRequested && !dirty )
+			{
+				return;
+			}
+		}
+	}
+};
+
 class GameFlow
 {
 public:
@@ -982,19 +2044,28 @@ public:
 	const Settings& settings;
 	ImFont* uiFont;
 	bool screenChanged = false;
+	// Set by screens that only change in response to input
+	bool screenStatic = false;
 	bool shutdownRequested = false;
+	bool allocationTestFailed = false;
 	Translator translator;
 
 	GameFlow( const Tiles& _tiles, const Settings& _settings, ImFont* _uiFont ) : tiles( _tiles ), settings( _settings ), uiFont( _uiFont )
 	{
 		currentHandler = &GameFlow::splashScreen;
 
+		if ( allocationTest && !AllocationTracker::isEnabled() )
+		{
+			TraceLog( LOG_WARNING, "ROBODANIEL_ALLOCATION_TEST needs a build with ROBODANIEL_TRACK_ALLOCATIONS" );
+		}
+
 		translator.setLanguage( Language::English );
 	}
 
 	void step()
 	{
 		screenChanged = false;
+		screenStatic = false;
 		currentHandler( this );
 	}
 
@@ -1003,90 +2074,60 @@ private:
 
 	static const int maxLevels = 10;
 
-	unique_ptr<Level> level;
-	unique_ptr<Session> session;
-	int nextLevel = 0;
-	optional<float> bestTime;
-
-	void pushUiStyle()
-	{
-		ImGui::PushFont( uiFont );
-		ImGui::PushStyleColor( ImGuiCol_WindowBg, ImVec4( 0, 0, 0, 0 ) );
-		ImGui::PushStyleColor( ImGuiCol_Text, ImVec4( 0, 0, 0, 1 ) );
-		ImGui::PushStyleColor( ImGuiCol_Border, ImVec4( 0, 0, 0, 0 ) );
-	}
-
-	void popUiStyle()
+	struct LoadedSession
 	{
-		ImGui::PopStyleColor( 3 );
-		ImGui::PopFont();
-	}
-
-	static std::filesystem::path getSavegamePath() {
-#if __WINDOWS
-		const std::filesystem::path home = std::getenv("APPDATA");
-#else
-		const std::filesystem::path home = std::getenv("HOME");
-#endif
-		return home / ".robodaniel" / "savegame.json";
-	}
+		int levelIndex = -1;
+		unique_ptr<Level> sourceLevel;
+		unique_ptr<Level> level;
+		unique_ptr<Session> session;
+	};
 
-	void saveBestTime( const int level, const float bestTime )
-	{
-		Savegame savegame;
+	unique_ptr<Level> sourceLevel;
+	unique_ptr<Level> level;
+	unique_ptr<Session> session;
+	LevelWatcher levelWatcher;
+	SavegameStore savegame{ getSavegamePath() };
+	LevelThumbnails thumbnails{ tiles, getUserDataPath() / "thumbnails" };
+	int nextLevel = 0;
+	optional<float> bestTime;
 
-		if (std::filesystem::exists(getSavegamePath())) {
-			std::ifstream stream(getSavegamePath());
-			nlohmann::json json;
-			stream >> json;
-			savegame = json;
-		}
+	future<LoadedSession> prefetchedSession;
+	int prefetchedLevelIndex = -1;
+	bool prefetchedHotReload = false;
 
-		bool present = false;
-		for (BestTime& best_time : savegame.bestTimes) {
-			if (best_time.level == level) {
-				best_time.time = bestTime;
-				present = true;
-			}
-		}
+	// When set, a play frame that allocates once the session has settled shuts the game down with an error
+	const bool allocationTest = std::getenv( "ROBODANIEL_ALLOCATION_TEST" ) != nullptr;
+	static const int allocationTestWarmupFrames = 60;
+	int playFrames = 0;
 
-		if (!present) {
-			savegame.bestTimes.push_back(BestTime{ level, bestTime });
-		}
+	// Whether the HUD rewind button was held down last frame
+	bool rewindButtonHeld = false;
 
-		{
-			std::error_code ec;
-			std::filesystem::create_directories(getSavegamePath().parent_path(), ec);
+	// Robots to start every session with, for load testing without the dev menu
+	const int crowdAgents = std::getenv( "ROBODANIEL_CROWD" ) ? std::atoi( std::getenv( "ROBODANIEL_CROWD" ) ) : 0;
 
-			std::ofstream stream(getSavegamePath());
-			nlohmann::json json;
-			json = savegame;
-			stream << json;
-		}
+	void pushUiStyle()
+	{
+		ImGui::PushFont( uiFont );
+		ImGui::PushStyleColor( ImGuiCol_WindowBg, ImVec4( 0, 0, 0, 0 ) );
+		ImGui::PushStyleColor( ImGuiCol_Text, ImVec4( 0, 0, 0, 1 ) );
+		ImGui::PushStyleColor( ImGuiCol_Border, ImVec4( 0, 0, 0, 0 ) );
 	}
 
-	optional<float> loadBestTime( const int level )
+	void popUiStyle()
 	{
-		if (std::filesystem::exists(getSavegamePath())) {
-			Savegame savegame;
-
-			std::ifstream stream(getSavegamePath());
-			nlohmann::json json;
-			stream >> json;
-			savegame = json;
+		ImGui::PopStyleColor( 3 );
+		ImGui::PopFont();
+	}
 
-			for (BestTime& best_time : savegame.bestTimes) {
-				if (best_time.level == level) {
-					return best_time.time;
-				}
-			}
-		}
-		
-		return std::nullopt;
+	static std::filesystem::path getSavegamePath() {
+		return getUserDataPath() / "savegame.json";
 	}
 
 	void splashScreen()
 	{
+		screenStatic = true;
+
 		pushUiStyle();
 
 		ImGui::CenterWindowForText( "____Robodaniel____" );
@@ -1142,28 +2183,56 @@ private:
 
 	void selectLevel( const array< optional<float>, maxLevels > bestTimes )
 	{
+		// Thumbnails arrive from worker threads, which no input announces
+		thumbnails.update();
+		screenStatic = !thumbnails.isLoading();
+
 		pushUiStyle();
-		ImGui::CenterWindowForText( "___Level XX___" );
+		const ImVec2 thumbnailSize( float( LevelThumbnails::width ), float( LevelThumbnails::height ) );
+		const float captionOffset = thumbnailSize.x + ImGui::GetStyle().ItemSpacing.x * 2;
+		ImGui::CenterWindow( captionOffset + ImGui::CalcTextSize( "___Level XX___" ).x );
 		if ( ImGui::Begin( "Select Level", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings ) )
 		{
-			for ( int i = 0; i < maxLevels; ++i )
+			// Rows are all as tall as a thumbnail, so the clipper submits only those on screen and the others are never read
+			const float rowHeight = thumbnailSize.y + ImGui::GetStyle().ItemSpacing.y;
+			const float listHeight = std::min( rowHeight * maxLevels, ImGui::GetIO().DisplaySize.y * 0.6f );
+			if ( ImGui::BeginChild( "Levels", ImVec2( 0, listHeight ) ) )
 			{
-				char caption[ 32 ];
-				sprintf( caption, translator.translate( "Level %2d" ).c_str(), i + 1 );
-
-				if ( bestTimes.at( i ).has_value() || ( i == 0 ) || ( i > 0 && bestTimes.at( i - 1 ).has_value() ) )
+				ImGuiListClipper clipper;
+				clipper.Begin( maxLevels, rowHeight );
+				while ( clipper.Step() )
 				{
-					if ( ImGui::CenteredButton( caption ) )
+					for ( int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i )
 					{
-						nextLevel = i;
-						screenChanged = true;
-						currentHandler = &GameFlow::initSession;
+						const Texture2D* thumbnail = thumbnails.get( i, getLevelPath( i ) );
+						if ( thumbnail )
+						{
+							rlImGuiImageSize( thumbnail, LevelThumbnails::width, LevelThumbnails::height );
+						} else
+						{
+							ImGui::Dummy( thumbnailSize );
+						}
+						ImGui::SameLine( captionOffset );
+
+						char caption[ 32 ];
+						sprintf( caption, translator.translate( "Level %2d" ), i + 1 );
+
+						if ( bestTimes.at( i ).has_value() || ( i == 0 ) || ( i > 0 && bestTimes.at( i - 1 ).has_value() ) )
+						{
+							if ( ImGui::Button( caption ) )
+							{
+								nextLevel = i;
+								screenChanged = true;
+								currentHandler = &GameFlow::initSession;
+							}
+						} else
+						{
+							ImGui::TextDisabled( caption );
+						}
 					}
-				} else
-				{
-					ImGui::CenteredTextDisabled( caption );
 				}
 			}
+			ImGui::EndChild();
 			if ( ImGui::CenteredButton( translator.translate( "Back" ) ) )
 			{
 				screenChanged = true;
@@ -1176,6 +2245,8 @@ private:
 
 	void credits()
 	{
+		screenStatic = true;
+
 		pushUiStyle();
 		ImGui::CenterWindowForText( "Tile and cloud art by Kenney Vleugels" );
 		if ( ImGui::Begin( "Best times", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings ) )
@@ -1204,7 +2275,7 @@ private:
 		array< optional<float>, maxLevels > bestTimes;
 		for ( int i = 0; i < maxLevels; ++i )
 		{
-			bestTimes.at( i ) = loadBestTime( i );
+			bestTimes.at( i ) = savegame.getBestTime( i );
 		}
 
 		return bestTimes;
@@ -1212,6 +2283,8 @@ private:
 
 	void showBestTimes( const array< optional<float>, maxLevels > bestTimes )
 	{
+		screenStatic = true;
+
 		pushUiStyle();
 		ImGui::CenterWindowForText( "Level XX      XXX.XXX s" );
 		if ( ImGui::Begin( "Best times", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings ) )
@@ -1222,20 +2295,20 @@ private:
 			{
 				if ( bestTimes.at( i ).has_value() )
 				{
-					ImGui::Text( translator.translate( "Level %2d      %7.3f s" ).c_str(), i + 1, *bestTimes.at( i ) );
+					ImGui::Text( translator.translate( "Level %2d      %7.3f s" ), i + 1, *bestTimes.at( i ) );
 					total += *bestTimes.at( i );
 				} else
 				{
-					ImGui::Text( translator.translate( "Level %2d      ------- s" ).c_str(), i + 1 );
+					ImGui::Text( translator.translate( "Level %2d      ------- s" ), i + 1 );
 					hasTotal = false;
 				}
 			}
 			if ( hasTotal )
 			{
-				ImGui::Text( translator.translate( "Total         %7.3f s" ).c_str(), total );
+				ImGui::Text( translator.translate( "Total         %7.3f s" ), total );
 			} else
 			{
-				ImGui::Text( translator.translate( "Total         ------- s" ).c_str() );
+				ImGui::Text( translator.translate( "Total         ------- s" ) );
 			}
 			if ( ImGui::CenteredButton( translator.translate( "Back" ) ) )
 			{
@@ -1247,21 +2320,156 @@ private:
 		popUiStyle();
 	}
 
+	// Runs on a worker thread: settings the main thread may change meanwhile are passed by value
+	static LoadedSession loadSession( const Tiles& tiles, const Settings& settings, const int levelIndex, const bool hotReloadLevel )
+	{
+		LoadedSession loaded;
+		loaded.levelIndex = levelIndex;
+		loaded.level.reset( new Level( getLevelPath( levelIndex ) ) );
+		replaceUnknownTiles( *loaded.level, tiles, levelIndex );
+		if ( hotReloadLevel )
+		{
+			loaded.sourceLevel.reset( new Level( *loaded.level ) );
+		}
+		loaded.session.reset( new Session( tiles, *loaded.level, settings ) );
+		return loaded;
+	}
+
+	static void replaceUnknownTiles( Level& level, const Tiles& tiles, const int levelIndex )
+	{
+		const int replaced = level.replaceUnknownTiles( tiles.getTileCount() );
+		if ( replaced > 0 )
+		{
+			TraceLog( LOG_WARNING, "Level %d: replaced %d unknown tiles with empty cells", levelIndex, replaced );
+		}
+	}
+
+	static filesystem::path getLevelPath( const int levelIndex )
+	{
+		return string( "level" ) + to_string( levelIndex ) + ".csv";
+	}
+
+	// Loads the given level on a worker thread, so that initSession only has to swap it in
+	void prefetchSession( const int levelIndex )
+	{
+		prefetchedSession = async( getJobLaunchPolicy(), &GameFlow::loadSession, cref( tiles ), cref( settings ), levelIndex, settings.debug.hotReloadLevel );
+		prefetchedLevelIndex = levelIndex;
+		prefetchedHotReload = settings.debug.hotReloadLevel;
+	}
+
 	void initSession()
 	{
-		filesystem::path levelPath = string( "level" ) + to_string( nextLevel ) + ".csv";
-		level.reset( new Level( levelPath ) );
-		session.reset( new Session( tiles, *level, settings ) );
-		bestTime = loadBestTime( nextLevel );
+		LoadedSession loaded;
+		if ( prefetchedSession.valid() && prefetchedLevelIndex == nextLevel && prefetchedHotReload == settings.debug.hotReloadLevel )
+		{
+			loaded = prefetchedSession.get();
+			prefetchedLevelIndex = -1;
+		} else
+		{
+			loaded = loadSession( tiles, settings, nextLevel, settings.debug.hotReloadLevel );
+		}
+
+		sourceLevel = std::move( loaded.sourceLevel );
+		level = std::move( loaded.level );
+		session = std::move( loaded.session );
+		bestTime = savegame.getBestTime( nextLevel );
+		const string ghostData = savegame.getGhost( nextLevel );
+		if ( !ghostData.empty() )
+		{
+			session->ghost.emplace( ghostData );
+		}
+		if ( crowdAgents > 0 )
+		{
+			session->startCrowd( crowdAgents );
+		}
+
+		if ( sourceLevel )
+		{
+			levelWatcher.watch( getLevelPath( nextLevel ) );
+		}
+		playFrames = 0;
 
 		screenChanged = true;
 		currentHandler = &GameFlow::play;
 	}
 
+	void reloadLevel()
+	{
+		try
+		{
+			vector<Vector2Int> changedCells;
+			unique_ptr<Level> newSourceLevel( new Level( getLevelPath( nextLevel ), *sourceLevel, changedCells ) );
+			replaceUnknownTiles( *newSourceLevel, tiles, nextLevel );
+			if ( Vector2IntEqual( newSourceLevel->getSize(), sourceLevel->getSize() ) )
+			{
+				// A cell whose unknown tile was just emptied may be back to what it was
+				changedCells.erase( std::remove_if( changedCells.begin(), changedCells.end(), [ this, &newSourceLevel ]( const Vector2Int& cell ) { return newSourceLevel->getCellAt( cell ) == sourceLevel->getCellAt( cell ); } ), changedCells.end() );
+				session->applyLevelEdit( *sourceLevel, *newSourceLevel, changedCells );
+				sourceLevel = std::move( newSourceLevel );
+			} else
+			{
+				// The level was resized, start over
+				screenChanged = true;
+				currentHandler = &GameFlow::initSession;
+			}
+		}
+		catch ( const exception& e )
+		{
+			TraceLog( LOG_WARNING, "Cannot reload level %d: %s", nextLevel, e.what() );
+		}
+	}
+
+	void showPathfinderStats()
+	{
+		if ( ImGui::Begin( "Path Search" ) )
+		{
+			const int searches = session->pathSearches;
+			const int historySize = std::min( searches, int( Session::pathfinderHistorySize ) );
+			if ( historySize == 0 )
+			{
+				ImGui::TextUnformatted( "No searches yet" );
+			} else
+			{
+				const PathfinderStats& last = session->pathfinderHistory.at( ( searches - 1 ) % Session::pathfinderHistorySize );
+				ImGui::Text( "Last: %.3f ms, %d dequeued, %d relaxations, %d re-enqueued", last.milliseconds, last.dequeued, last.relaxations, last.reenqueues );
+				ImGui::Text( "      peak queue %d, %d allocations", last.peakQueueSize, last.allocations );
+
+				vector<float> times;
+				PathfinderStats worst;
+				for ( int i = searches - historySize; i < searches; ++i )
+				{
+					const PathfinderStats& stats = session->pathfinderHistory.at( i % Session::pathfinderHistorySize );
+					times.push_back( float( stats.milliseconds ) );
+					if ( stats.milliseconds > worst.milliseconds )
+					{
+						worst = stats;
+					}
+				}
+				ImGui::Text( "Last %d: mean %.3f ms, p90 %.3f ms", historySize, std::accumulate( times.begin(), times.end(), 0.0f ) / times.size(), Profiler::getPercentile( times, 90 ) );
+				ImGui::Text( "Slowest: %.3f ms, %d dequeued, %d re-enqueued", worst.milliseconds, worst.dequeued, worst.reenqueues );
+				ImGui::PlotLines( "ms", times.data(), int( times.size() ), 0, nullptr, 0, FLT_MAX, ImVec2( 0, 60 ) );
+			}
+		}
+		ImGui::End();
+	}
+
 	void play()
 	{
+		ALLOCATION_SCOPE( "play" );
+
+		// Reload level if its file changed
+		if ( sourceLevel && levelWatcher.poll() )
+		{
+			thumbnails.invalidate( nextLevel );
+			reloadLevel();
+			playFrames = 0;
+		}
+
+		const AllocationTracker::Counters allocationsBefore = AllocationTracker::getThreadCounters();
+		++playFrames;
+
 		// Step session
-		session->step();
+		session->step( rewindButtonHeld || IsKeyDown( KEY_BACKSPACE ) );
 
 		// Render UI
 		{
@@ -1269,13 +2477,15 @@ private:
 			pushUiStyle();
 			if ( ImGui::Begin( "HUD", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings ) )
 			{
-				ImGui::Text( translator.translate( "Coins %2d/%2d" ).c_str(), session->collectedCoins, session->totalCoins );
-				ImGui::Text( translator.translate( "Time %7.3f" ).c_str(), session->totalTime );
+				ImGui::Text( translator.translate( "Coins %2d/%2d" ), session->collectedCoins, session->totalCoins );
+				ImGui::Text( translator.translate( "Time %7.3f" ), session->getTotalTime() );
 				if ( bestTime.has_value() )
 				{
-					ImGui::Text( translator.translate( "Best %7.3f" ).c_str(), *bestTime );
+					ImGui::Text( translator.translate( "Best %7.3f" ), *bestTime );
 				}
-				if ( ImGui::Button( translator.translate( "Back" ).c_str() ) )
+				ImGui::Button( translator.translate( "Rewind" ) );
+				rewindButtonHeld = ImGui::IsItemActive();
+				if ( ImGui::Button( translator.translate( "Back" ) ) )
 				{
 					screenChanged = true;
 					currentHandler = &GameFlow::splashScreen;
@@ -1285,27 +2495,64 @@ private:
 			popUiStyle();
 		}
 
+		if ( settings.debug.pathStats )
+		{
+			showPathfinderStats();
+		}
+
 		// Render level
-		BeginMode2D( settings.debug.enableDebugCamera ? settings.debug.debugCamera : session->gameplayCamera );
+		session->prepareRender();
+		BeginMode2D( session->getActiveCamera() );
 		session->render();
 
 		if ( settings.debug.pathDebugDraw && !session->currentPath.empty() )
 		{
 			for ( int i = 0; i < session->currentPath.size() - 1; ++i )
 			{
-				DrawLineV( Vector2{ float( session->currentPath.at( i ).coords.x ) + 0.5f, float( session->currentPath.at( i ).coords.y ) + 0.5f },
-					Vector2{ float( session->currentPath.at( i + 1 ).coords.x ) + 0.5f, float( session->currentPath.at( i + 1 ).coords.y ) + 0.5f }, BLUE );
+				DrawLineV( Vector2FixedToFloat( getCellCenter( Vector2IntZero() ) + session->currentPath.at( i ).coords ),
+					Vector2FixedToFloat( getCellCenter( Vector2IntZero() ) + session->currentPath.at( i + 1 ).coords ), BLUE );
+			}
+		}
+
+		// Cells expanded by the last search, from yellow for once to red for the most expanded
+		if ( settings.debug.pathHeatmap && !session->pathfinder.getExpansionCounts().empty() )
+		{
+			const vector<int>& expansions = session->pathfinder.getExpansionCounts();
+			const int maxExpansions = *std::max_element( expansions.begin(), expansions.end() );
+			const int width = session->level.getSize().x;
+			for ( int i = 0; i < expansions.size(); ++i )
+			{
+				if ( expansions[ i ] > 0 )
+				{
+					const float heat = maxExpansions > 1 ? float( expansions[ i ] - 1 ) / ( maxExpansions - 1 ) : 0;
+					DrawRectangleV( Vector2IntToFloat( Vector2IntFromIndex( i, width ) ), Vector2{ 1, 1 }, Color{ 255, static_cast<unsigned char>( 255 * ( 1 - heat ) ), 0, 128 } );
+				}
 			}
 		}
 
 		EndMode2D();
 
+		if ( allocationTest && playFrames > allocationTestWarmupFrames )
+		{
+			const AllocationTracker::Counters& allocationsAfter = AllocationTracker::getThreadCounters();
+			if ( allocationsAfter.allocations != allocationsBefore.allocations )
+			{
+				TraceLog( LOG_ERROR, "Play frame %d allocated %d times (%d bytes)", playFrames, int( allocationsAfter.allocations - allocationsBefore.allocations ), int( allocationsAfter.bytes - allocationsBefore.bytes ) );
+				allocationTestFailed = true;
+				shutdownRequested = true;
+			}
+		}
+
 		if ( session->completed )
 		{
 			currentHandler = &GameFlow::sessionCompleted;
-			if ( !bestTime.has_value() || session->totalTime < *bestTime )
+			if ( !session->rewound && ( !bestTime.has_value() || session->getTotalTime() < *bestTime ) )
+			{
+				savegame.setBestTime( nextLevel, session->getTotalTime(), session->ghostRecorder.getData() );
+			}
+			if ( nextLevel + 1 < maxLevels )
 			{
-				saveBestTime( nextLevel, session->totalTime );
+				prefetchSession( nextLevel + 1 );
 			}
 		} else if ( session->failed )
 		{
@@ -1315,7 +2562,10 @@ private:
 
 	void sessionCompleted()
 	{
-		BeginMode2D( settings.debug.enableDebugCamera ? settings.debug.debugCamera : session->gameplayCamera );
+		screenStatic = true;
+
+		session->prepareRender();
+		BeginMode2D( session->getActiveCamera() );
 		session->render();
 		EndMode2D();
 
@@ -1323,8 +2573,8 @@ private:
 		ImGui::CenterWindowForText( "_Level completed in xx.xxx seconds!_" );
 		if ( ImGui::Begin( "Session completed", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings ) )
 		{
-			ImGui::Text( translator.translate( "Level completed in %.3f seconds!" ).c_str(), session->totalTime );
-			if ( !bestTime.has_value() || session->totalTime < *bestTime )
+			ImGui::Text( translator.translate( "Level completed in %.3f seconds!" ), session->getTotalTime() );
+			if ( !session->rewound && ( !bestTime.has_value() || session->getTotalTime() < *bestTime ) )
 			{
 				ImGui::CenteredText( translator.translate( "New best time!" ) );
 			}
@@ -1363,7 +2613,10 @@ private:
 
 	void sessionFailed()
 	{
-		BeginMode2D( settings.debug.enableDebugCamera ? settings.debug.debugCamera : session->gameplayCamera );
+		screenStatic = true;
+
+		session->prepareRender();
+		BeginMode2D( session->getActiveCamera() );
 		session->render();
 		EndMode2D();
 
@@ -1391,53 +2644,233 @@ private:
 	}
 };
 
+// Clouds baked into one render texture per layer, so that drawing the background costs a few quads regardless of the cloud count
+class Background
+{
+public:
+	// Decodes the cloud images, which needs no GPU, so that it can run on a worker thread
+	static array<Image, 3> decodeClouds()
+	{
+		const array<const char*, 3> cloudPaths{ "cloud1.png", "cloud2.png", "cloud3.png" };
+		array<Image, 3> images;
+		for ( int i = 0; i < cloudPaths.size(); ++i )
+		{
+			// Premultiplied, so that layers composite exactly over each other
+			images.at( i ) = LoadImage( cloudPaths.at( i ) );
+			ImageAlphaPremultiply( &images.at( i ) );
+		}
+		return images;
+	}
+
+	// Uploads the decoded clouds and frees their images
+	Background( const Settings& _settings, const array<Image, 3>& clouds ) : settings( _settings )
+	{
+		for ( int i = 0; i < clouds.size(); ++i )
+		{
+			cloudTextures.at( i ) = LoadTextureFromImage( clouds.at( i ) );
+			UnloadImage( clouds.at( i ) );
+		}
+	}
+
+	~Background()
+	{
+		unloadLayers();
+		for ( const Texture2D& texture : cloudTextures )
+		{
+			UnloadTexture( texture );
+		}
+	}
+
+	Background( const Background& ) = delete;
+	Background& operator=( const Background& ) = delete;
+
+	// Must be called outside of any texture or 2D mode
+	void update( const bool screenChanged )
+	{
+		const int wantedLayers = settings.background.parallax ? std::max( 1, settings.background.parallaxLayers ) : 1;
+		if ( screenChanged || IsWindowResized() || layers.size() != wantedLayers || cloudCount != settings.background.clouds )
+		{
+			regenerate( wantedLayers );
+		}
+	}
+
+	void render() const
+	{
+		BeginBlendMode( BLEND_ALPHA_PREMULTIPLY );
+		for ( int i = 0; i < layers.size(); ++i )
+		{
+			const Texture2D& texture = layers.at( i ).texture;
+			const Rectangle source{ 0, 0, float( texture.width ), -float( texture.height ) };
+
+			if ( settings.background.parallax )
+			{
+				// Farther layers scroll slower; each layer wraps around horizontally
+				const float offset = fmodf( float( GetTime() ) * settings.background.parallaxSpeed * ( i + 1 ), float( texture.width ) );
+				DrawTextureRec( texture, source, Vector2{ -offset, 0 }, WHITE );
+				DrawTextureRec( texture, source, Vector2{ texture.width - offset, 0 }, WHITE );
+			} else
+			{
+				DrawTextureRec( texture, source, Vector2{ 0, 0 }, WHITE );
+			}
+		}
+		EndBlendMode();
+	}
+
+private:
+	const Settings& settings;
+	array<Texture2D, 3> cloudTextures;
+	vector<RenderTexture2D> layers;
+	int cloudCount = 0;
+
+	void regenerate( const int layerCount )
+	{
+		unloadLayers();
+
+		const int width = GetScreenWidth();
+		const int height = GetScreenHeight();
+		cloudCount = settings.background.clouds;
+		if ( width <= 0 || height <= 0 )
+		{
+			return;
+		}
+
+		for ( int i = 0; i < layerCount; ++i )
+		{
+			RenderTexture2D layer = LoadRenderTexture( width, height );
+			BeginTextureMode( layer );
+			ClearBackground( BLANK );
+			BeginBlendMode( BLEND_ALPHA_PREMULTIPLY );
+
+			// Clouds crossing the right border are drawn again on the left, so that layers tile seamlessly
+			for ( int j = i; j < cloudCount; j += layerCount )
+			{
+				const Texture2D& texture = cloudTextures.at( rand() % cloudTextures.size() );
+				const Vector2 position{ float( rand() % width ), float( rand() % height ) };
+				DrawTextureEx( texture, position, 0, 2, WHITE );
+				if ( position.x + texture.width * 2 > width )
+				{
+					DrawTextureEx( texture, Vector2{ position.x - width, position.y }, 0, 2, WHITE );
+				}
+			}
+
+			EndBlendMode();
+			EndTextureMode();
+			layers.push_back( layer );
+		}
+	}
+
+	void unloadLayers()
+	{
+		for ( const RenderTexture2D& layer : layers )
+		{
+			UnloadRenderTexture( layer );
+		}
+		layers.clear();
+	}
+};
+
+static void logLoadTime( const char* what, const chrono::steady_clock::time_point& startTime )
+{
+	const chrono::duration<double, milli> time = chrono::steady_clock::now() - startTime;
+	TraceLog( LOG_INFO, "%s loaded after %.2f ms", what, time.count() );
+}
+
 int main()
 {
+	const auto startTime = chrono::steady_clock::now();
+	bool firstFrame = true;
+	// For startup timing runs: ROBODANIEL_STARTUP_TEST quits once the first game frame is logged, and
+	// ROBODANIEL_NO_FONT_CACHE rasterizes the fonts as if the atlas cache did not exist
+	const bool startupTest = std::getenv( "ROBODANIEL_STARTUP_TEST" ) != nullptr;
+	const bool fontCacheEnabled = std::getenv( "ROBODANIEL_NO_FONT_CACHE" ) == nullptr;
+
 	SetConfigFlags( FLAG_WINDOW_RESIZABLE );
 	InitWindow( 1280, 720, "Game" );
 
 	rlImGuiSetup(true);
+	Settings settings;
+
+	// Images are decoded and fonts rasterized on worker threads behind a loading screen; each one is uploaded here as soon as it
+	// is ready, since only the main thread may use the GPU
+	const launch policy = getJobLaunchPolicy();
+	ImVector<ImWchar> glyphRanges;
+	FontAtlasCache fontCache( getUserDataPath() / "fontatlas.cache", fontCacheEnabled );
+	future<vector<ImFont*>> fontsJob = async( policy, [ &fontCache, &glyphRanges ]()
+		{
+			glyphRanges = buildGlyphRanges();
+			return fontCache.build( { { "DroidSans.ttf", 24.0f }, { "ProggyTiny.ttf", 48.0f } }, glyphRanges.Data );
+		} );
+	future<Tiles::Atlases> tilesJob = async( policy, &Tiles::decodeAtlases, string( "tiles.png" ), 128 );
+	future<array<Image, 3>> cloudsJob = async( policy, &Background::decodeClouds );
+
 	ImFont* uiFont = nullptr;
+	unique_ptr<Tiles> tiles;
+	unique_ptr<Background> background;
+	const int assetCount = 3;
+	while ( !uiFont || !tiles || !background )
 	{
-		ImGuiIO& io = ImGui::GetIO();
-		io.Fonts->Clear();
-		io.Fonts->AddFontFromFileTTF( "DroidSans.ttf", 24.0f );
-		uiFont = io.Fonts->AddFontFromFileTTF( "ProggyTiny.ttf", 48.0f );
-		rlImGuiReloadFonts();
-	}
+		if ( WindowShouldClose() )
+		{
+			// The jobs still running are waited for by their futures
+			CloseWindow();
+			return 0;
+		}
 
-	array<Texture2D, 3> cloudTextures;
-	cloudTextures[ 0 ] = LoadTexture( "cloud1.png" );
-	cloudTextures[ 1 ] = LoadTexture( "cloud2.png" );
-	cloudTextures[ 2 ] = LoadTexture( "cloud3.png" );
+		// A progress bar needs no font and no translation, neither of which is loaded yet
+		const int loaded = ( uiFont != nullptr ) + ( tiles != nullptr ) + ( background != nullptr );
+		const Rectangle bar{ GetScreenWidth() * 0.25f, GetScreenHeight() * 0.5f - 8, GetScreenWidth() * 0.5f, 16 };
+		BeginDrawing();
+		ClearBackground( Color{ 208, 244, 247, 255 } );
+		DrawRectangleRec( Rectangle{ bar.x, bar.y, bar.width * loaded / assetCount, bar.height }, DARKBLUE );
+		DrawRectangleLinesEx( bar, 2, DARKBLUE );
+		EndDrawing();
 
-	typedef tuple<int, int, int> Cloud;
-	vector<Cloud> clouds;
+		if ( firstFrame )
+		{
+			const chrono::duration<double, milli> timeToFirstFrame = chrono::steady_clock::now() - startTime;
+			TraceLog( LOG_INFO, "Time to first frame: %.2f ms (loading screen)", timeToFirstFrame.count() );
+			firstFrame = false;
+		}
 
-	auto regenClouds = [&clouds, &cloudTextures]()
-	{
-		clouds.clear();
-		for ( int i = 0; i < 30; ++i )
+		// One asset per frame, so that the bar moves even where the jobs are deferred and run right here
+		if ( isReady( fontsJob ) )
+		{
+			uiFont = fontsJob.get().at( 1 );
+			rlImGuiReloadFonts();
+			logLoadTime( !fontCache.isEnabled() ? "Fonts (atlas cache disabled)" : fontCache.isHit() ? "Fonts (atlas cache hit)" : "Fonts (atlas cache miss)", startTime );
+		} else if ( isReady( tilesJob ) )
 		{
-			clouds.push_back( { rand() % GetScreenWidth(), rand() % GetScreenHeight(), rand() % cloudTextures.size() } );
+			tiles = make_unique<Tiles>( tilesJob.get() );
+			logLoadTime( "Tiles", startTime );
+		} else if ( isReady( cloudsJob ) )
+		{
+			background = make_unique<Background>( settings, cloudsJob.get() );
+			logLoadTime( "Clouds", startTime );
 		}
-	};
-	regenClouds();
+	}
 
-	Tiles tiles( "tiles.png", 128 );
-	Settings settings;
-	GameFlow flow( tiles, settings, uiFont );
+	GameFlow flow( *tiles, settings, uiFont );
+	bool firstGameFrame = true;
 	bool showSettings = false;
+	bool showProfiler = false;
+	bool showAllocations = false;
+	const int idleSettleFrames = 3;
+	int framesBeforeIdle = idleSettleFrames;
 
 	while ( !WindowShouldClose() )
 	{
-		rlImGuiBegin();
+		{
+			PROFILE_SCOPE( "rlImGuiBegin" );
+			rlImGuiBegin();
+		}
 
 		if ( ImGui::BeginDevMenuBar() )
 		{
 			if ( ImGui::BeginMenu( "Game" ) )
 			{
 				ImGui::MenuItem( "Show Settings", nullptr, &showSettings );
+				ImGui::MenuItem( "Show Profiler", nullptr, &showProfiler );
+				ImGui::MenuItem( "Show Allocations", nullptr, &showAllocations );
 				if ( ImGui::MenuItem( "Create blank savegame" ) )
 				{
 					ofstream stream( "storage.data" );
@@ -1466,6 +2899,18 @@ int main()
 					ImGui::SliderFloat( "Coin Collision Radius", &settings.gameplay.coinRadius, 0, 0.5f );
 					ImGui::DragFloat( "Enemy Speed", &settings.gameplay.enemySpeed, 0.01f );
 					ImGui::SliderFloat( "Enemy Collision Radius", &settings.gameplay.enemyRadius, 0, 0.5f );
+					ImGui::SliderFloat( "Rewind Speed", &settings.gameplay.rewindSpeed, 0.1f, 8.0f );
+				}
+
+				if ( ImGui::CollapsingHeader( "Background" ) )
+				{
+					ImGui::SliderInt( "Clouds", &settings.background.clouds, 0, 1000 );
+					ImGui::Checkbox( "Parallax", &settings.background.parallax );
+					if ( settings.background.parallax )
+					{
+						ImGui::SliderInt( "Parallax Layers", &settings.background.parallaxLayers, 1, 8 );
+						ImGui::DragFloat( "Parallax Speed", &settings.background.parallaxSpeed, 0.1f );
+					}
 				}
 
 				if ( ImGui::CollapsingHeader( "Debug" ) )
@@ -1484,6 +2929,51 @@ int main()
 						}
 					}
 					ImGui::Checkbox( "Hero Path", &settings.debug.pathDebugDraw );
+					ImGui::Checkbox( "Path Search Heatmap", &settings.debug.pathHeatmap );
+					ImGui::Checkbox( "Path Search Stats", &settings.debug.pathStats );
+					ImGui::Checkbox( "Hot Reload Level", &settings.debug.hotReloadLevel );
+					ImGui::Text( "Sprite Draw Calls %d", SpriteBatch::getDrawCalls() );
+				}
+			}
+			ImGui::End();
+		}
+
+		if ( showProfiler )
+		{
+			if ( ImGui::Begin( "Profiler", &showProfiler ) )
+			{
+				const vector<float> frameTimes = Profiler::getFrameTimes();
+				const vector<float> frameTimeCounts = Profiler::getHistogram( frameTimes, 1, 50 );
+				ImGui::PlotLines( "Frame ms", frameTimes.data(), int( frameTimes.size() ), 0, nullptr, 0, 50, ImVec2( 0, 80 ) );
+				ImGui::PlotHistogram( "Frames", frameTimeCounts.data(), int( frameTimeCounts.size() ), 0, "1 ms buckets, 0 to 50 ms", 0, FLT_MAX, ImVec2( 0, 80 ) );
+				ImGui::Text( "p50 %.2f ms  p90 %.2f ms  p99 %.2f ms", Profiler::getPercentile( frameTimes, 50 ), Profiler::getPercentile( frameTimes, 90 ), Profiler::getPercentile( frameTimes, 99 ) );
+				if ( ImGui::Button( "Export Chrome Trace" ) )
+				{
+					if ( Profiler::exportChromeTrace( "profile.json" ) )
+					{
+						TraceLog( LOG_INFO, "Profile written to profile.json" );
+					}
+				}
+			}
+			ImGui::End();
+		}
+
+		if ( showAllocations )
+		{
+			if ( ImGui::Begin( "Allocations", &showAllocations ) )
+			{
+				if ( AllocationTracker::isEnabled() )
+				{
+					const AllocationTracker::Counters& frame = AllocationTracker::getLastFrame();
+					ImGui::Text( "Last frame: %d allocations, %d bytes", int( frame.allocations ), int( frame.bytes ) );
+					for ( int i = 0; i < AllocationTracker::getScopeCount(); ++i )
+					{
+						const AllocationTracker::ScopeCounters& scope = AllocationTracker::getScope( i );
+						ImGui::Text( "%-16s %6d allocations %8d bytes", scope.name, int( scope.lastFrame.allocations ), int( scope.lastFrame.bytes ) );
+					}
+				} else
+				{
+					ImGui::TextUnformatted( "Build with ROBODANIEL_TRACK_ALLOCATIONS to count allocations" );
 				}
 			}
 			ImGui::End();
@@ -1491,31 +2981,65 @@ int main()
 
 		BeginDrawing();
 		{
+			background->update( flow.screenChanged );
+
 			const Color bgColor{ 208, 244, 247, 255 };
 			ClearBackground( bgColor );
+			background->render();
 
-			for ( const auto& cloud : clouds )
 			{
-				DrawTextureEx( cloudTextures.at( get<2>( cloud ) ), Vector2{ float( get<0>( cloud ) ), float( get<1>( cloud ) ) }, 0, 2, WHITE );
+				PROFILE_SCOPE( "flow.step" );
+				ALLOCATION_SCOPE( "flow.step" );
+				flow.step();
+			}
+			SpriteBatch::endFrame();
+
+			if ( flow.shutdownRequested )
+			{
+				break;
 			}
 
-			flow.step();
+			{
+				PROFILE_SCOPE( "rlImGuiEnd" );
+				rlImGuiEnd();
+			}
 
-			if ( flow.screenChanged )
+			// On static screens, block until the next input event once a few frames let ImGui settle
+			if ( flow.screenStatic && !flow.screenChanged && !settings.background.parallax )
+			{
+				--framesBeforeIdle;
+			} else
+			{
+				framesBeforeIdle = idleSettleFrames;
+			}
+			if ( framesBeforeIdle <= 0 )
+			{
+				EnableEventWaiting();
+				framesBeforeIdle = idleSettleFrames;
+			} else
 			{
-				regenClouds();
+				DisableEventWaiting();
 			}
+		}
+		{
+			PROFILE_SCOPE( "EndDrawing" );
+			EndDrawing();
+		}
+		Profiler::endFrame();
+		AllocationTracker::endFrame();
 
-			if ( flow.shutdownRequested )
+		if ( firstGameFrame )
+		{
+			const chrono::duration<double, milli> timeToFirstGameFrame = chrono::steady_clock::now() - startTime;
+			TraceLog( LOG_INFO, "Time to first game frame: %.2f ms", timeToFirstGameFrame.count() );
+			firstGameFrame = false;
+			if ( startupTest )
 			{
 				break;
 			}
-
-			rlImGuiEnd();
 		}
-		EndDrawing();
 	}
 
 	CloseWindow();
-	return 0;
+	return flow.allocationTestFailed ? 1 : 0;
 }
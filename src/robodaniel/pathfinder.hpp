@@ -0,0 +1,680 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <queue>
+#include <chrono>
+#include <utility>
+#include <initializer_list>
+#include <type_traits>
+#include <raylib.h>
+#include <raymath.h>
+#include <intmath.hpp>
+#include <level.hpp>
+#include <profiler.hpp>
+
+// Coordinates and progress are fixed point, so that following a path is bit exact on every platform
+struct PathPoint
+{
+	Vector2Fixed coords;
+	// In cells along the path
+	Fixed progress;
+	unsigned int moveFlags;
+};
+
+// For every cell, the first move of a shortest path to one target cell, shared by everyone heading there
+struct FlowField
+{
+	static constexpr uint8_t noMove = 0xff;
+
+	Vector2Int target;
+	// Move index per cell, noMove where the target cannot be reached or is reached already
+	std::vector<uint8_t> moves;
+	// Path length to the target per cell, -1 where it cannot be reached
+	std::vector<float> distances;
+};
+
+enum MoveFlags
+{
+	MoveFlags_None = 0x0,
+	MoveFlags_NeedsSolidBottom = 0x1,
+	MoveFlags_JumpAnimation = 0x2,
+	MoveFlags_MirroredAnimation = 0x4,
+};
+
+// Counters of a single search, to find the geometry that makes it slow
+struct PathfinderStats
+{
+	int dequeued = 0;
+	int relaxations = 0;
+	// Cells queued again, after they were expanded, because a shorter path to them was found
+	int reenqueues = 0;
+	int peakQueueSize = 0;
+	// Search buffers that had to grow, the per-cell states and the queue; they are kept between searches, and trajectories
+	// are stored in place
+	int allocations = 0;
+	double milliseconds = 0;
+};
+
+// No move of any move set may take more steps than this
+static const int maxMoveSteps = 8;
+
+struct MoveDefinition
+{
+	const char* description;
+	unsigned int flags;
+	int stepCount;
+	// Cells the move passes through, relative to where it starts
+	std::array<Vector2Int, maxMoveSteps> steps;
+};
+
+constexpr MoveDefinition makeMove( const char* description, const unsigned int flags, const std::initializer_list<Vector2Int> steps )
+{
+	MoveDefinition move{ description, flags, int( steps.size() ), {} };
+	int i = 0;
+	for ( const Vector2Int& step : steps )
+	{
+		// A move longer than maxMoveSteps fails to compile here
+		move.steps[ i++ ] = step;
+	}
+	return move;
+}
+
+// A move set is a type with a constexpr array of moves. The pathfinder is instantiated per move set, so every move and step
+// count is known at compile time.
+struct HeroMoveSet
+{
+	static constexpr std::array<MoveDefinition, 7> moves
+	{ {
+		makeMove( "Right", MoveFlags_NeedsSolidBottom, { { 1, 0 } } ),
+		makeMove( "Right Long Jump", MoveFlags_NeedsSolidBottom | MoveFlags_JumpAnimation, { { 1, -1 }, { 2, -1 }, { 3, 0 } } ),
+		makeMove( "Right High Jump", MoveFlags_NeedsSolidBottom | MoveFlags_JumpAnimation, { { 0, -1 }, { 0, -2 }, { 0, -3 }, { 1, -3 } } ),
+		makeMove( "Left", MoveFlags_NeedsSolidBottom | MoveFlags_MirroredAnimation, { { -1, 0 } } ),
+		makeMove( "Left Long Jump", MoveFlags_NeedsSolidBottom | MoveFlags_MirroredAnimation | MoveFlags_JumpAnimation, { { -1, -1 }, { -2, -1 }, { -3, 0 } } ),
+		makeMove( "Left High Jump", MoveFlags_NeedsSolidBottom | MoveFlags_MirroredAnimation | MoveFlags_JumpAnimation, { { 0, -1 }, { 0, -2 }, { 0, -3 }, { -1, -3 } } ),
+		makeMove( "Gravity", MoveFlags_JumpAnimation, { { 0, 1 } } ),
+	} };
+};
+
+template<typename MoveSet>
+constexpr int getMoveSetStepCount()
+{
+	int count = 0;
+	for ( const MoveDefinition& move : MoveSet::moves )
+	{
+		count += move.stepCount;
+	}
+	return count;
+}
+
+template<typename MoveSet>
+constexpr int getMoveSetLongestMove()
+{
+	int longest = 0;
+	for ( const MoveDefinition& move : MoveSet::moves )
+	{
+		longest = std::max( longest, move.stepCount );
+	}
+	return longest;
+}
+
+// The steps of every move in one array, so that all the cells a move can reach are found and bounds checked in one batch
+template<typename MoveSet>
+constexpr std::array<Vector2Int, getMoveSetStepCount<MoveSet>()> getMoveSetSteps()
+{
+	std::array<Vector2Int, getMoveSetStepCount<MoveSet>()> steps{};
+	int i = 0;
+	for ( const MoveDefinition& move : MoveSet::moves )
+	{
+		for ( int step = 0; step < move.stepCount; ++step )
+		{
+			steps[ i++ ] = move.steps[ step ];
+		}
+	}
+	return steps;
+}
+
+template<typename MoveSet>
+constexpr std::array<int, MoveSet::moves.size()> getMoveSetFirstSteps()
+{
+	std::array<int, MoveSet::moves.size()> firstSteps{};
+	int first = 0;
+	for ( size_t i = 0; i < MoveSet::moves.size(); ++i )
+	{
+		firstSteps[ i ] = first;
+		first += MoveSet::moves[ i ].stepCount;
+	}
+	return firstSteps;
+}
+
+// Length of each step of every move, from the previous one, or from the start of the move when cumulative
+template<typename MoveSet>
+std::array<float, getMoveSetStepCount<MoveSet>()> getMoveSetStepDistances( const bool cumulative )
+{
+	std::array<float, getMoveSetStepCount<MoveSet>()> distances{};
+	int i = 0;
+	for ( const MoveDefinition& move : MoveSet::moves )
+	{
+		Vector2Int previous = Vector2IntZero();
+		float distance = 0;
+		for ( int step = 0; step < move.stepCount; ++step )
+		{
+			const float stepDistance = Vector2Distance( Vector2IntToFloat( previous ), Vector2IntToFloat( move.steps[ step ] ) );
+			distance = cumulative ? distance + stepDistance : stepDistance;
+			distances[ i++ ] = distance;
+			previous = move.steps[ step ];
+		}
+	}
+	return distances;
+}
+
+template<typename MoveSet>
+class BasicPathfinder
+{
+private:
+	static constexpr int moveCount = int( MoveSet::moves.size() );
+	static constexpr int stepCount = getMoveSetStepCount<MoveSet>();
+	static constexpr std::array<Vector2Int, stepCount> allSteps = getMoveSetSteps<MoveSet>();
+	static constexpr std::array<int, moveCount> firstStepOfMove = getMoveSetFirstSteps<MoveSet>();
+	// Cells of the longest move, including the one it starts from
+	static constexpr int trajectoryCapacity = getMoveSetLongestMove<MoveSet>() + 1;
+	// Square roots are not constexpr, so these are computed once per move set at startup
+	static inline const std::array<float, stepCount> stepDistances = getMoveSetStepDistances<MoveSet>( false );
+	static inline const std::array<float, stepCount> allStepDistances = getMoveSetStepDistances<MoveSet>( true );
+
+	static_assert( moveCount < FlowField::noMove, "Move indices must fit a flow field" );
+
+	// Calls function with each move index as a compile time constant, so that the loops over a move's steps unroll
+	template<typename Function, size_t... moveIndices>
+	static void forEachMove( Function&& function, std::index_sequence<moveIndices...> )
+	{
+		( function( std::integral_constant<int, int( moveIndices )>() ), ... );
+	}
+
+public:
+	BasicPathfinder( const Level& _level ) : level( _level )
+	{
+		// The search queue holds each cell at most once at a time, and a path visits each cell at most once, so searches on
+		// this level never grow these
+		const int cellCount = level.getSize().x * level.getSize().y;
+		searchCellStates.reserve( cellCount );
+		searchQueue.reserve( cellCount );
+		pathPositions.reserve( cellCount );
+		smoothPath.reserve( 4 * trajectoryCapacity );
+		smoothScratch.reserve( 4 * trajectoryCapacity );
+	}
+
+	static constexpr int getMoveCount()
+	{
+		return moveCount;
+	}
+
+	static constexpr const MoveDefinition& getMove( const int moveIndex )
+	{
+		return MoveSet::moves[ moveIndex ];
+	}
+
+	static constexpr unsigned int getMoveFlags( const int moveIndex )
+	{
+		return MoveSet::moves[ moveIndex ].flags;
+	}
+
+	// Steps of the move taken from the given cell before something blocks it, 0 if the move cannot start there
+	int getMoveLength( const Vector2Int& position, const int moveIndex ) const
+	{
+		const MoveDefinition& move = MoveSet::moves[ moveIndex ];
+		if ( move.flags & MoveFlags_NeedsSolidBottom )
+		{
+			const Vector2Int below = position + Vector2Int{ 0, 1 };
+			if ( !Vector2IntInBounds( below, level.getSize() ) || !Tiles::isImpassable( level.getCellAt( below ) ) )
+			{
+				return 0;
+			}
+		}
+
+		int length = 0;
+		for ( int step = 0; step < move.stepCount; ++step )
+		{
+			const Vector2Int stepPosition = position + move.steps[ step ];
+			if ( !Vector2IntInBounds( stepPosition, level.getSize() ) || Tiles::isImpassable( level.getCellAt( stepPosition ) ) )
+			{
+				break;
+			}
+			++length;
+		}
+
+		return length;
+	}
+
+	// Shortest paths from every cell to the target, by a Dijkstra search backwards over the moves: the cells a move can end on
+	// the target from are found by stepping back from it, so the move graph is never stored
+	FlowField computeFlowField( const Vector2Int& target ) const
+	{
+		PROFILE_SCOPE( "Pathfinder::computeFlowField" );
+
+		FlowField field;
+		field.target = target;
+		field.moves.assign( level.getSize().x * level.getSize().y, FlowField::noMove );
+		field.distances.assign( field.moves.size(), -1 );
+		if ( !Vector2IntInBounds( target, level.getSize() ) || Tiles::isImpassable( level.getCellAt( target ) ) )
+		{
+			return field;
+		}
+
+		typedef std::pair<float, int> QueueEntry;
+		std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> cellsToVisit;
+		field.distances[ Vector2IntToIndex( target, level.getSize().x ) ] = 0;
+		cellsToVisit.push( QueueEntry{ 0.0f, Vector2IntToIndex( target, level.getSize().x ) } );
+
+		while ( !cellsToVisit.empty() )
+		{
+			const QueueEntry entry = cellsToVisit.top();
+			cellsToVisit.pop();
+			if ( entry.first > field.distances[ entry.second ] )
+			{
+				continue;
+			}
+
+			const Vector2Int end = Vector2IntFromIndex( entry.second, level.getSize().x );
+			for ( int moveIndex = 0; moveIndex < moveCount; ++moveIndex )
+			{
+				const int firstStep = firstStepOfMove[ moveIndex ];
+				for ( int length = 1; length <= MoveSet::moves[ moveIndex ].stepCount; ++length )
+				{
+					const Vector2Int start = end - allSteps[ firstStep + length - 1 ];
+					if ( !Vector2IntInBounds( start, level.getSize() ) || Tiles::isImpassable( level.getCellAt( start ) ) || getMoveLength( start, moveIndex ) != length )
+					{
+						continue;
+					}
+
+					const int startIndex = Vector2IntToIndex( start, level.getSize().x );
+					const float distance = entry.first + allStepDistances[ firstStep + length - 1 ];
+					if ( field.distances[ startIndex ] < 0 || distance < field.distances[ startIndex ] )
+					{
+						field.distances[ startIndex ] = distance;
+						field.moves[ startIndex ] = uint8_t( moveIndex );
+						cellsToVisit.push( QueueEntry{ distance, startIndex } );
+					}
+				}
+			}
+		}
+
+		return field;
+	}
+
+	std::vector<PathPoint> goTo( const Vector2Int& currentPosition, const Vector2Int& destination )
+	{
+		std::vector<PathPoint> trajectory;
+		goTo( currentPosition, destination, trajectory );
+		return trajectory;
+	}
+
+	// Replaces trajectory with the path to the destination, empty if there is none. Reuses the capacity of trajectory and of
+	// the search buffers, so a search allocates nothing once they are big enough. The counters and expansion counts of
+	// getLastStats and getExpansionCounts cost time, so they are only gathered with collectStats; the time always is.
+	void goTo( const Vector2Int& currentPosition, const Vector2Int& destination, std::vector<PathPoint>& trajectory, const bool collectStats = false )
+	{
+		PROFILE_SCOPE( "Pathfinder::goTo" );
+		const auto startTime = std::chrono::steady_clock::now();
+
+		lastStats = PathfinderStats();
+		findPath( currentPosition, destination, trajectory, collectStats );
+		lastStats.milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startTime ).count();
+	}
+
+	// Counters of the last goTo search
+	const PathfinderStats& getLastStats() const
+	{
+		return lastStats;
+	}
+
+	// How many times each cell was expanded by the last goTo search that collected stats, row by row
+	const std::vector<int>& getExpansionCounts() const
+	{
+		return expansionCounts;
+	}
+
+	// Returns, for every cell of the level, whether the hero can pass through it starting from the given position
+	std::vector<bool> findReachableCells( const Vector2Int& start ) const
+	{
+		std::vector<CellState> states;
+		std::vector<Vector2Int> positions;
+		search( start, states, positions );
+
+		std::vector<bool> result( states.size() );
+		for ( int i = 0; i < states.size(); ++i )
+		{
+			result[ i ] = states[ i ].shortestPath >= 0;
+		}
+
+		return result;
+	}
+
+	// Returns the cell where the hero comes to rest when falling from the given position, or a cell below the level if it falls off
+	Vector2Int findLandingCell( const Vector2Int& position ) const
+	{
+		Vector2Int landing = position;
+		while ( landing.y + 1 < level.getSize().y && !Tiles::isImpassable( level.getCellAt( Vector2Int{ landing.x, landing.y + 1 } ) ) )
+		{
+			++landing.y;
+		}
+
+		if ( landing.y + 1 >= level.getSize().y )
+		{
+			landing.y = level.getSize().y;
+		}
+
+		return landing;
+	}
+
+	// Smooths a cell path by subdivision, interpolating progress along it; halving and quartering integer cells stays exact in fixed point
+	static std::vector<PathPoint> catmullClark( const std::vector<Vector2Int>& path, const int iterations, const int progressOffset, const unsigned int moveFlags )
+	{
+		std::vector<PathPoint> points;
+		std::vector<PathPoint> scratch;
+		catmullClark( path.data(), int( path.size() ), iterations, progressOffset, moveFlags, points, scratch );
+		return points;
+	}
+
+	// Same, into points, with scratch for the intermediate iterations, so that reused vectors make it allocation free
+	static void catmullClark( const Vector2Int* path, const int count, const int iterations, const int progressOffset, const unsigned int moveFlags, std::vector<PathPoint>& points, std::vector<PathPoint>& scratch )
+	{
+		points.clear();
+		for ( int i = 0; i < count; ++i )
+		{
+			points.push_back( PathPoint{ Vector2FixedFromInt( path[ i ] ), Fixed::fromInt( progressOffset + i ), moveFlags } );
+		}
+
+		if ( points.size() < 3 )
+		{
+			return;
+		}
+
+		auto midpointAt = [ &points, moveFlags ]( const int i )
+		{
+			PathPoint midpoint;
+			midpoint.coords = Vector2Fixed{ ( points[ i ].coords.x + points[ i + 1 ].coords.x ) / 2, ( points[ i ].coords.y + points[ i + 1 ].coords.y ) / 2 };
+			midpoint.progress = ( points[ i ].progress + points[ i + 1 ].progress ) / 2;
+			midpoint.moveFlags = moveFlags;
+			return midpoint;
+		};
+
+		int iterationsToDo = iterations;
+		while ( iterationsToDo-- )
+		{
+			const int midpointCount = int( points.size() ) - 1;
+			scratch.clear();
+			scratch.push_back( points.front() );
+			PathPoint midpoint = midpointAt( 0 );
+			for ( int i = 0; i < midpointCount - 1; ++i )
+			{
+				const PathPoint nextMidpoint = midpointAt( i + 1 );
+				scratch.push_back( midpoint );
+
+				PathPoint newPoint;
+				newPoint.coords.x = ( points[ i + 1 ].coords.x * 2 + midpoint.coords.x + nextMidpoint.coords.x ) / 4;
+				newPoint.coords.y = ( points[ i + 1 ].coords.y * 2 + midpoint.coords.y + nextMidpoint.coords.y ) / 4;
+				newPoint.progress = points[ i + 1 ].progress;
+				newPoint.moveFlags = moveFlags;
+				scratch.push_back( newPoint );
+
+				midpoint = nextMidpoint;
+			}
+			scratch.push_back( midpoint );
+			scratch.push_back( points.back() );
+
+			points.swap( scratch );
+		}
+	}
+
+private:
+	// The cells of a move from its start, held in place since no move of the set is longer than its longest one
+	struct Trajectory
+	{
+		std::array<Vector2Int, trajectoryCapacity> positions;
+		int size = 0;
+
+		void clear()
+		{
+			size = 0;
+		}
+
+		void push_back( const Vector2Int& position )
+		{
+			positions[ size++ ] = position;
+		}
+
+		const Vector2Int& front() const
+		{
+			return positions[ 0 ];
+		}
+
+		const Vector2Int& back() const
+		{
+			return positions[ size - 1 ];
+		}
+
+		const Vector2Int* begin() const
+		{
+			return positions.data();
+		}
+
+		const Vector2Int* end() const
+		{
+			return positions.data() + size;
+		}
+	};
+
+	struct CellState
+	{
+		float shortestPath = -1;
+		Trajectory trajectory;
+		unsigned int moveFlags;
+		// Waiting in the search queue; an improved cell that is already waiting is not queued again
+		bool queued = false;
+	};
+
+	const Level& level;
+	PathfinderStats lastStats;
+	std::vector<int> expansionCounts;
+
+	// Buffers of goTo, kept between searches for their capacity
+	std::vector<CellState> searchCellStates;
+	std::vector<Vector2Int> searchQueue;
+	std::vector<Vector2Int> pathPositions;
+	std::vector<PathPoint> smoothPath;
+	std::vector<PathPoint> smoothScratch;
+
+	void findPath( const Vector2Int& currentPosition, const Vector2Int& destination, std::vector<PathPoint>& trajectory, const bool collectStats )
+	{
+		trajectory.clear();
+		if ( currentPosition == destination )
+		{
+			return;
+		}
+
+		search( currentPosition, searchCellStates, searchQueue, collectStats ? &lastStats : nullptr, collectStats ? &expansionCounts : nullptr );
+		auto cellAt = [ this, mapWidth = level.getSize().x ]( const Vector2Int& position )->const CellState& { return searchCellStates.at( Vector2IntToIndex( position, mapWidth ) ); };
+
+		const CellState& destinationCell = cellAt( destination );
+		if ( destinationCell.shortestPath == -1 )
+		{
+			return;
+		}
+
+		pathPositions.clear();
+		{
+			Vector2Int position = destination;
+			while ( true )
+			{
+				pathPositions.push_back( position );
+				if ( position == currentPosition )
+				{
+					break;
+				}
+
+				position = cellAt( position ).trajectory.front();
+			}
+
+			std::reverse( pathPositions.begin(), pathPositions.end() );
+		}
+
+		trajectory.push_back( PathPoint{ Vector2FixedFromInt( currentPosition ), Fixed(), MoveFlags_None } );
+		int progressOffset = 0;
+		Vector2Int lastPosition = currentPosition;
+		for ( int i = 1; i < pathPositions.size(); ++i )
+		{
+			const CellState& cell = cellAt( pathPositions.at( i ) );
+			catmullClark( cell.trajectory.begin(), cell.trajectory.size, 2, progressOffset, cell.moveFlags, smoothPath, smoothScratch );
+			trajectory.insert( trajectory.end(), smoothPath.begin() + 1, smoothPath.end() );
+			progressOffset += cell.trajectory.size - 1;
+			lastPosition = cell.trajectory.back();
+		}
+
+		while ( true )
+		{
+			const Vector2Int below{ lastPosition.x, lastPosition.y + 1 };
+			if ( below.y >= level.getSize().y )
+			{
+				trajectory.push_back( PathPoint{ Vector2FixedFromInt( below ), trajectory.back().progress + Fixed::fromInt( 1 ), MoveFlags_JumpAnimation } );
+				break;
+			} else if ( !Tiles::isImpassable( level.getCellAt( below ) ) )
+			{
+				trajectory.push_back( PathPoint{ Vector2FixedFromInt( below ), trajectory.back().progress + Fixed::fromInt( 1 ), MoveFlags_JumpAnimation } );
+				lastPosition = below;
+				continue;
+			} else
+			{
+				break;
+			}
+		}
+	}
+
+	// Fills cellStates from the given start, using positionsToVisit as a FIFO ring of one slot per cell; both keep their
+	// capacity. A cell is labelled again whenever a shorter path to it is found, but only queued if it is not waiting already,
+	// so the ring never overflows. Stats and expansion counts are only gathered when given.
+	void search( const Vector2Int& start, std::vector<CellState>& cellStates, std::vector<Vector2Int>& positionsToVisit, PathfinderStats* stats = nullptr, std::vector<int>* expansions = nullptr ) const
+	{
+		const size_t cellCount = size_t( level.getSize().x ) * level.getSize().y;
+		if ( stats )
+		{
+			stats->allocations = ( cellStates.capacity() < cellCount ? 1 : 0 ) + ( positionsToVisit.capacity() < cellCount ? 1 : 0 );
+		}
+		cellStates.assign( cellCount, CellState() );
+		auto cellAt = [ &cellStates, mapWidth = level.getSize().x ]( const Vector2Int& position )->CellState& { return cellStates.at( Vector2IntToIndex( position, mapWidth ) ); };
+		auto cellIndex = [ mapWidth = level.getSize().x ]( const Vector2Int& position ) { return Vector2IntToIndex( position, mapWidth ); };
+
+		std::vector<bool> enqueued;
+		if ( stats )
+		{
+			enqueued.assign( cellStates.size(), false );
+			enqueued[ cellIndex( start ) ] = true;
+		}
+		if ( expansions )
+		{
+			expansions->assign( cellStates.size(), 0 );
+		}
+
+		positionsToVisit.resize( cellCount );
+		size_t head = 0;
+		size_t queueSize = 0;
+		auto enqueue = [ & ]( const Vector2Int& position )
+		{
+			CellState& cell = cellAt( position );
+			if ( cell.queued )
+			{
+				return;
+			}
+			cell.queued = true;
+			const size_t tail = head + queueSize;
+			positionsToVisit[ tail < cellCount ? tail : tail - cellCount ] = position;
+			++queueSize;
+		};
+
+		cellAt( start ).shortestPath = 0;
+		enqueue( start );
+
+		Trajectory trajectory;
+		std::array<Vector2Int, stepCount> stepPositions;
+		std::array<uint8_t, stepCount> stepInBounds;
+
+		while ( queueSize > 0 )
+		{
+			if ( stats )
+			{
+				stats->peakQueueSize = std::max<int>( stats->peakQueueSize, int( queueSize ) );
+				++stats->dequeued;
+			}
+
+			const Vector2Int position = positionsToVisit[ head ];
+			head = head + 1 < cellCount ? head + 1 : 0;
+			--queueSize;
+			cellAt( position ).queued = false;
+
+			if ( expansions )
+			{
+				++( *expansions )[ cellIndex( position ) ];
+			}
+
+			Vector2IntAddBatch( allSteps.data(), position, stepPositions.data(), stepCount );
+			Vector2IntInBoundsBatch( stepPositions.data(), level.getSize(), stepInBounds.data(), stepCount );
+			const Vector2Int below = position + Vector2Int{ 0, 1 };
+			const bool solidBottom = Vector2IntInBounds( below, level.getSize() ) && Tiles::isImpassable( level.getCellAt( below ) );
+
+			const CellState& currentCell = cellAt( position );
+			forEachMove( [ & ]( auto moveIndexConstant )
+			{
+				constexpr int moveIndex = decltype( moveIndexConstant )::value;
+				constexpr const MoveDefinition& move = MoveSet::moves[ moveIndex ];
+				constexpr int firstStep = firstStepOfMove[ moveIndex ];
+				if ( ( move.flags & MoveFlags_NeedsSolidBottom ) && !solidBottom )
+				{
+					return;
+				}
+
+				trajectory.clear();
+				trajectory.push_back( position );
+				for ( int step = firstStep; step < firstStep + move.stepCount; ++step )
+				{
+					if ( !stepInBounds[ step ] || Tiles::isImpassable( level.getCellAt( stepPositions[ step ] ) ) )
+					{
+						break;
+					}
+
+					trajectory.push_back( stepPositions[ step ] );
+				}
+
+				float currentPathLength = currentCell.shortestPath;
+				for ( int step = 1; step < trajectory.size; ++step )
+				{
+					currentPathLength += stepDistances[ firstStep + step - 1 ];
+
+					CellState& cell = cellAt( trajectory.positions[ step ] );
+					if ( cell.shortestPath < 0 || currentPathLength < cell.shortestPath )
+					{
+						if ( stats )
+						{
+							++stats->relaxations;
+						}
+
+						cell.shortestPath = currentPathLength;
+						cell.trajectory = trajectory;
+						cell.moveFlags = move.flags;
+
+						if ( step == trajectory.size - 1 )
+						{
+							if ( stats && !cell.queued )
+							{
+								const int index = cellIndex( trajectory.positions[ step ] );
+								stats->reenqueues += enqueued[ index ];
+								enqueued[ index ] = true;
+							}
+							enqueue( trajectory.positions[ step ] );
+						}
+					}
+				}
+			}, std::make_index_sequence<moveCount>() );
+		}
+	}
+};
+
+typedef BasicPathfinder<HeroMoveSet> Pathfinder;
@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <array>
+
+// Scoped timing markers, kept in a ring buffer per thread and exported as a Chrome trace
+class Profiler
+{
+public:
+	struct Event
+	{
+		const char* name;
+		int64_t start;
+		int64_t end;
+		int depth;
+	};
+
+	// Must be a power of two
+	static const size_t eventsPerThread = 1 << 15;
+	static const size_t frameHistory = 240;
+
+private:
+	// Written only by its own thread, so pushing an event takes no lock
+	struct ThreadBuffer
+	{
+		std::unique_ptr<Event[]> events{ new Event[ eventsPerThread ] };
+		std::atomic<size_t> written{ 0 };
+		int depth = 0;
+
+		void push( const Event& event )
+		{
+			const size_t index = written.load( std::memory_order_relaxed );
+			events[ index & ( eventsPerThread - 1 ) ] = event;
+			written.store( index + 1, std::memory_order_release );
+		}
+	};
+
+	struct State
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		// Buffers of threads that exited, handed to the next threads so that short-lived workers do not each keep one
+		std::vector<ThreadBuffer*> freeBuffers;
+		const int64_t origin = now();
+
+		std::array<float, frameHistory> frameTimes{};
+		size_t frameCount = 0;
+		int64_t lastFrameEnd = 0;
+	};
+
+public:
+	class Scope
+	{
+	public:
+		Scope( const char* _name ) : name( _name ), buffer( getThreadBuffer() ), start( now() )
+		{
+			++buffer.depth;
+		}
+
+		~Scope()
+		{
+			--buffer.depth;
+			buffer.push( Event{ name, start, now(), buffer.depth } );
+		}
+
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+
+	private:
+		const char* name;
+		ThreadBuffer& buffer;
+		const int64_t start;
+	};
+
+	// Called once per frame on the main thread, between two EndDrawing calls
+	static void endFrame()
+	{
+		State& state = getState();
+		const int64_t time = now();
+		if ( state.lastFrameEnd != 0 )
+		{
+			state.frameTimes[ state.frameCount % frameHistory ] = float( time - state.lastFrameEnd ) / 1e6f;
+			++state.frameCount;
+		}
+		state.lastFrameEnd = time;
+	}
+
+	// Frame times in milliseconds, oldest first
+	static std::vector<float> getFrameTimes()
+	{
+		const State& state = getState();
+		const size_t count = std::min( state.frameCount, frameHistory );
+
+		std::vector<float> result;
+		result.reserve( count );
+		for ( size_t i = state.frameCount - count; i < state.frameCount; ++i )
+		{
+			result.push_back( state.frameTimes[ i % frameHistory ] );
+		}
+		return result;
+	}
+
+	// Number of frames per bucket of bucketMs milliseconds; the last bucket also counts every slower frame
+	static std::vector<float> getHistogram( const std::vector<float>& frameTimes, const float bucketMs, const int bucketCount )
+	{
+		std::vector<float> counts( bucketCount, 0.0f );
+		for ( const float time : frameTimes )
+		{
+			counts[ std::clamp( int( time / bucketMs ), 0, bucketCount - 1 ) ] += 1;
+		}
+		return counts;
+	}
+
+	static float getPercentile( std::vector<float> values, const float percentile )
+	{
+		if ( values.empty() )
+		{
+			return 0;
+		}
+
+		const size_t index = std::min( values.size() - 1, size_t( percentile / 100.0f * values.size() ) );
+		std::nth_element( values.begin(), values.begin() + index, values.end() );
+		return values[ index ];
+	}
+
+	// Writes the events still held by every thread's ring buffer; events of other threads that are being overwritten meanwhile may come out garbled
+	static bool exportChromeTrace( const std::string& path )
+	{
+		std::ofstream stream( path );
+		stream << "{\"traceEvents\":[";
+
+		bool first = true;
+		State& state = getState();
+		std::lock_guard<std::mutex> lock( state.mutex );
+		for ( size_t thread = 0; thread < state.buffers.size(); ++thread )
+		{
+			const ThreadBuffer& buffer = *state.buffers[ thread ];
+			const size_t end = buffer.written.load( std::memory_order_acquire );
+			const size_t begin = end > eventsPerThread ? end - eventsPerThread : 0;
+			for ( size_t i = begin; i < end; ++i )
+			{
+				const Event& event = buffer.events[ i & ( eventsPerThread - 1 ) ];
+				stream << ( first ? "" : "," ) << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+					<< ",\"ts\":" << ( event.start - state.origin ) / 1000.0 << ",\"dur\":" << ( event.end - event.start ) / 1000.0 << "}";
+				first = false;
+			}
+		}
+
+		stream << "\n]}\n";
+		return bool( stream );
+	}
+
+private:
+	static State& getState()
+	{
+		static State state;
+		return state;
+	}
+
+	// Returns its thread's buffer to the free list when the thread exits
+	struct ThreadBufferOwner
+	{
+		ThreadBuffer* buffer = nullptr;
+
+		~ThreadBufferOwner()
+		{
+			if ( buffer )
+			{
+				State& state = getState();
+				std::lock_guard<std::mutex> lock( state.mutex );
+				state.freeBuffers.push_back( buffer );
+			}
+		}
+	};
+
+	// Buffers stay registered after their thread exits, so that the export still sees their events until another thread reuses them
+	static ThreadBuffer& getThreadBuffer()
+	{
+		thread_local ThreadBufferOwner owner;
+		if ( !owner.buffer )
+		{
+			State& state = getState();
+			std::lock_guard<std::mutex> lock( state.mutex );
+			if ( state.freeBuffers.empty() )
+			{
+				state.buffers.push_back( std::make_unique<ThreadBuffer>() );
+				owner.buffer = state.buffers.back().get();
+			} else
+			{
+				owner.buffer = state.freeBuffers.back();
+				state.freeBuffers.pop_back();
+			}
+		}
+		return *owner.buffer;
+	}
+
+	static int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	}
+};
+
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+#define PROFILE_SCOPE( name ) Profiler::Scope PROFILE_CONCAT( profileScope, __LINE__ )( name )
@@ -0,0 +1,220 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <intmath.hpp>
+
+// Session history for rewinding: a ring buffer of per tick deltas, with a keyframe every ticksPerKeyframe ticks so that a seek
+// replays at most that many deltas. All storage is allocated by reset, so that recording never allocates.
+class RewindBuffer
+{
+public:
+	static const int ticksPerKeyframe = 120;
+	// Room for one more keyframe every this many ticks on average, for the ticks whose changes do not fit a delta
+	static const int ticksPerExtraKeyframe = 15;
+
+	// What the path the hero follows was searched from, so that a seek can search it again instead of storing it
+	struct PathInput
+	{
+		// Tick after which the path was searched, or -1 when the hero has no path
+		int startTick = -1;
+		Vector2Int start{ 0, 0 };
+		Vector2Int destination{ 0, 0 };
+	};
+
+	// Session state that changes from tick to tick
+	struct State
+	{
+		int tick = 0;
+		Vector2Fixed heroPosition;
+		unsigned int heroMoveFlags = 0;
+		// Raw fixed point distance walked by every enemy since the buffer was reset
+		int64_t enemyDistance = 0;
+		// Changes at most once per click, so every change gets a keyframe
+		PathInput path;
+	};
+
+	// A level cell written during a tick, with the tile it replaced
+	struct CellChange
+	{
+		int index = 0;
+		int oldTile = 0;
+		int newTile = 0;
+	};
+
+	RewindBuffer( const int ticks ) : deltas( std::max( ticks, 2 * ticksPerKeyframe ) ), keyframes( deltas.size() / ticksPerKeyframe + deltas.size() / ticksPerExtraKeyframe + 2 ) { }
+
+	static bool isSamePath( const PathInput& a, const PathInput& b )
+	{
+		return a.startTick == b.startTick && Vector2IntEqual( a.start, b.start ) && Vector2IntEqual( a.destination, b.destination );
+	}
+
+	// Starts the history over from the given state; cellChangeCapacity is the most cell changes held at once
+	void reset( const State& state, const size_t cellChangeCapacity )
+	{
+		cellChanges.assign( std::max<size_t>( cellChangeCapacity, 1 ), CellChange() );
+		firstKeyframe = endKeyframe = 0;
+		firstCellChange = endCellChange = 0;
+		restartAt( state, 0 );
+	}
+
+	int getFirstTick() const
+	{
+		return getKeyframe( firstKeyframe ).state.tick;
+	}
+
+	int getLastTick() const
+	{
+		return lastState.tick;
+	}
+
+	// Records the state after the next tick and the cells that tick changed
+	void push( const State& state, const CellChange* changes, const int changeCount )
+	{
+		if ( changeCount > std::numeric_limits<uint8_t>::max() || endCellChange - firstCellChange + changeCount > cellChanges.size() )
+		{
+			// The changes do not fit, so the history starts over at this tick, which needs none of them
+			firstKeyframe = endKeyframe;
+			restartAt( state, changeCount );
+			return;
+		}
+
+		for ( int i = 0; i < changeCount; ++i )
+		{
+			cellChanges[ endCellChange++ % cellChanges.size() ] = changes[ i ];
+		}
+
+		Delta& delta = getDelta( state.tick );
+		const bool fits = encode( lastState, state, delta );
+		delta.cellChanges = uint8_t( changeCount );
+		if ( !fits || state.tick % ticksPerKeyframe == 0 )
+		{
+			pushKeyframe( state );
+		}
+		lastState = state;
+
+		// The ring now holds the deltas of the last deltas.size() ticks; older keyframes can no longer be replayed from
+		while ( endKeyframe - firstKeyframe > 1 && getKeyframe( firstKeyframe ).state.tick < state.tick - int( deltas.size() ) + 1 )
+		{
+			dropOldestKeyframe();
+		}
+	}
+
+	// Returns the state after the given tick, clamped to the buffered ones, and forgets every later tick. The cells changed since
+	// are passed to undo, newest first.
+	template<typename Undo>
+	State rewindTo( const int tick, Undo&& undo )
+	{
+		const int target = std::clamp( tick, getFirstTick(), lastState.tick );
+
+		for ( int i = lastState.tick; i > target; --i )
+		{
+			for ( int j = 0; j < getDelta( i ).cellChanges; ++j )
+			{
+				undo( cellChanges[ --endCellChange % cellChanges.size() ] );
+			}
+		}
+
+		while ( getKeyframe( endKeyframe - 1 ).state.tick > target )
+		{
+			--endKeyframe;
+		}
+
+		State state = getKeyframe( endKeyframe - 1 ).state;
+		while ( state.tick < target )
+		{
+			++state.tick;
+			const Delta& delta = getDelta( state.tick );
+			state.heroPosition.x += Fixed::fromRaw( delta.heroX );
+			state.heroPosition.y += Fixed::fromRaw( delta.heroY );
+			state.heroMoveFlags = delta.heroMoveFlags;
+			state.enemyDistance += delta.enemyDistance;
+		}
+
+		lastState = state;
+		return state;
+	}
+
+private:
+	// 8 bytes per tick: 16 bits are enough for what changes in a tick at any sensible speed, and keyframes cover the rest
+	struct Delta
+	{
+		int16_t heroX = 0;
+		int16_t heroY = 0;
+		int16_t enemyDistance = 0;
+		uint8_t heroMoveFlags = 0;
+		uint8_t cellChanges = 0;
+	};
+
+	struct Keyframe
+	{
+		State state;
+		// End of the cell changes up to and including this tick, which a rewind to it keeps
+		size_t cellChangeEnd = 0;
+	};
+
+	std::vector<Delta> deltas;
+	std::vector<Keyframe> keyframes;
+	std::vector<CellChange> cellChanges;
+	// Keyframes and cell changes are counted from the reset; the rings hold those from first to end
+	size_t firstKeyframe = 0;
+	size_t endKeyframe = 0;
+	size_t firstCellChange = 0;
+	size_t endCellChange = 0;
+	State lastState;
+
+	Delta& getDelta( const int tick )
+	{
+		return deltas[ tick % deltas.size() ];
+	}
+
+	const Keyframe& getKeyframe( const size_t index ) const
+	{
+		return keyframes[ index % keyframes.size() ];
+	}
+
+	void restartAt( const State& state, const int changeCount )
+	{
+		firstCellChange = endCellChange = endCellChange + changeCount;
+		Delta& delta = getDelta( state.tick );
+		delta = Delta();
+		delta.cellChanges = uint8_t( std::min( changeCount, int( std::numeric_limits<uint8_t>::max() ) ) );
+		pushKeyframe( state );
+		lastState = state;
+	}
+
+	void pushKeyframe( const State& state )
+	{
+		if ( endKeyframe - firstKeyframe == keyframes.size() )
+		{
+			dropOldestKeyframe();
+		}
+		keyframes[ endKeyframe++ % keyframes.size() ] = Keyframe{ state, endCellChange };
+	}
+
+	void dropOldestKeyframe()
+	{
+		++firstKeyframe;
+		firstCellChange = getKeyframe( firstKeyframe ).cellChangeEnd;
+	}
+
+	static bool encode( const State& from, const State& to, Delta& delta )
+	{
+		const int64_t heroX = to.heroPosition.x.raw - from.heroPosition.x.raw;
+		const int64_t heroY = to.heroPosition.y.raw - from.heroPosition.y.raw;
+		const int64_t enemyDistance = to.enemyDistance - from.enemyDistance;
+		const bool fits = fitsInt16( heroX ) && fitsInt16( heroY ) && fitsInt16( enemyDistance ) && to.heroMoveFlags <= std::numeric_limits<uint8_t>::max() && isSamePath( from.path, to.path );
+
+		delta.heroX = fits ? int16_t( heroX ) : 0;
+		delta.heroY = fits ? int16_t( heroY ) : 0;
+		delta.enemyDistance = fits ? int16_t( enemyDistance ) : 0;
+		delta.heroMoveFlags = uint8_t( to.heroMoveFlags );
+		return fits;
+	}
+
+	static bool fitsInt16( const int64_t value )
+	{
+		return value >= std::numeric_limits<int16_t>::min() && value <= std::numeric_limits<int16_t>::max();
+	}
+};
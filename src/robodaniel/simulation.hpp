@@ -0,0 +1,140 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <raylib.h>
+#include <raymath.h>
+#include <intmath.hpp>
+#include <level.hpp>
+
+// The simulation advances in fixed ticks and keeps its state in fixed point, so that a run replays bit exactly everywhere
+static const int simulationTicksPerSecond = 120;
+
+// Distance covered in one tick at the given speed in cells per second
+inline Fixed getDistancePerTick( const float speed )
+{
+	return Fixed::fromFloat( speed ) / simulationTicksPerSecond;
+}
+
+constexpr inline Vector2Fixed getCellCenter( const Vector2Int& cell )
+{
+	const Fixed half = Fixed::fromRaw( Fixed::rawOne / 2 );
+	return Vector2FixedFromInt( cell ) + Vector2Fixed{ half, half };
+}
+
+// An enemy walks back and forth between two cells
+struct Enemy
+{
+	Vector2Int blueprintCell;
+	Vector2Int startCell;
+	Vector2Int endCell;
+	Fixed progress;
+	// Center of the enemy, and where it was one tick earlier to draw it between ticks
+	Vector2Fixed position;
+	Vector2Fixed previousPosition;
+};
+
+inline Enemy createEnemyFromBlueprint( const Vector2Int& cellPosition, const int blueprint )
+{
+	const TileProperties properties = Tiles::getProperties( blueprint );
+	const int pathLength = std::max<int>( properties.pathLength, 1 );
+	const bool horizontal = properties.flags & TileFlags_Horizontal;
+	const bool startsAtEnd = properties.flags & TileFlags_StartsAtEnd;
+
+	Enemy enemy;
+	enemy.blueprintCell = cellPosition;
+	enemy.startCell = cellPosition;
+	if ( horizontal )
+	{
+		enemy.endCell = Vector2Int{ cellPosition.x + pathLength - 1, cellPosition.y };
+	} else
+	{
+		enemy.endCell = Vector2Int{ cellPosition.x, cellPosition.y - ( pathLength - 1 ) };
+	}
+	if ( startsAtEnd )
+	{
+		std::swap( enemy.startCell, enemy.endCell );
+	}
+	enemy.progress = Fixed();
+	enemy.position = getCellCenter( enemy.startCell );
+	enemy.previousPosition = enemy.position;
+
+	return enemy;
+}
+
+// Distance of a walk to the end cell and back; paths are straight, so it is twice the cells between the ends
+inline Fixed getEnemyLoopLength( const Enemy& enemy )
+{
+	const Vector2Int delta = enemy.endCell - enemy.startCell;
+	return Fixed::fromInt( 2 * ( std::abs( delta.x ) + std::abs( delta.y ) ) );
+}
+
+// Moves the enemy by the given distance; the position is the start plus the distance along the path direction
+inline void updateEnemy( Enemy& enemy, const Fixed& distance )
+{
+	const Vector2Int delta = enemy.endCell - enemy.startCell;
+	const Fixed fullLength = getEnemyLoopLength( enemy );
+	const Fixed halfLength = fullLength / 2;
+	const Vector2Fixed startPosition = getCellCenter( enemy.startCell );
+
+	enemy.previousPosition = enemy.position;
+	if ( halfLength == Fixed() )
+	{
+		enemy.position = startPosition;
+		return;
+	}
+
+	enemy.progress = ( enemy.progress + distance ) % fullLength;
+	const Fixed distanceFromStart = enemy.progress < halfLength ? enemy.progress : fullLength - enemy.progress;
+	const Vector2Int direction{ ( delta.x > 0 ) - ( delta.x < 0 ), ( delta.y > 0 ) - ( delta.y < 0 ) };
+	enemy.position = startPosition + Vector2Fixed{ distanceFromStart * direction.x, distanceFromStart * direction.y };
+}
+
+// Position to draw the enemy at, the given fraction of a tick after its last update
+inline Vector2 getEnemyRenderPosition( const Enemy& enemy, const float tickFraction )
+{
+	return Vector2Lerp( Vector2FixedToFloat( enemy.previousPosition ), Vector2FixedToFloat( enemy.position ), tickFraction );
+}
+
+// What the hero touches at its current position; the caller applies the outcome
+struct HeroContacts
+{
+	Vector2Int touchedTile;
+	bool outOfLevel = false;
+	bool coin = false;
+	bool openExit = false;
+	bool enemy = false;
+};
+
+inline HeroContacts findHeroContacts( const Level& level, const Vector2Fixed& heroPosition, const std::vector<Enemy>& enemies, const Fixed& coinRadius, const Fixed& enemyRadius )
+{
+	HeroContacts contacts;
+
+	const Vector2Fixed heroCenter = heroPosition + getCellCenter( Vector2IntZero() );
+	contacts.touchedTile = Vector2FixedFloor( heroCenter );
+	const Vector2Int& touchedTile = contacts.touchedTile;
+
+	if ( !Vector2IntInBounds( touchedTile, level.getSize() ) )
+	{
+		contacts.outOfLevel = true;
+		return contacts;
+	}
+
+	const Vector2Fixed touchedTileCenter = getCellCenter( touchedTile );
+	constexpr Fixed exitRadius = Fixed::fromRaw( Fixed::rawOne / 10 );
+
+	const int cell = level.getCellAt( touchedTile );
+	contacts.coin = cell == Tiles::getCoin() && Vector2FixedWithinDistance( heroCenter, touchedTileCenter, coinRadius );
+	contacts.openExit = cell == Tiles::getOpenExit() && Vector2FixedWithinDistance( heroCenter, touchedTileCenter, exitRadius );
+
+	for ( const Enemy& enemy : enemies )
+	{
+		if ( Vector2FixedWithinDistance( heroCenter, enemy.position, enemyRadius ) )
+		{
+			contacts.enemy = true;
+			break;
+		}
+	}
+
+	return contacts;
+}
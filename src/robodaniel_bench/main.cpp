@@ -0,0 +1,334 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <array>
+#include <string>
+#include <filesystem>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <raylib.h>
+#include <intmath.hpp>
+#include <nlohmann/json.hpp>
+
+#include <level.hpp>
+#include <pathfinder.hpp>
+#include <simulation.hpp>
+#include <crowd.hpp>
+
+using namespace std;
+
+// The hero's moves plus a double jump each way, to measure what a larger move set costs the pathfinder
+struct DoubleJumpMoveSet
+{
+	static constexpr array<MoveDefinition, 9> moves
+	{ {
+		HeroMoveSet::moves[ 0 ], HeroMoveSet::moves[ 1 ], HeroMoveSet::moves[ 2 ], HeroMoveSet::moves[ 3 ], HeroMoveSet::moves[ 4 ], HeroMoveSet::moves[ 5 ], HeroMoveSet::moves[ 6 ],
+		makeMove( "Right Double Jump", MoveFlags_NeedsSolidBottom | MoveFlags_JumpAnimation, { { 0, -1 }, { 0, -2 }, { 0, -3 }, { 0, -4 }, { 0, -5 }, { 0, -6 }, { 1, -6 } } ),
+		makeMove( "Left Double Jump", MoveFlags_NeedsSolidBottom | MoveFlags_MirroredAnimation | MoveFlags_JumpAnimation, { { 0, -1 }, { 0, -2 }, { 0, -3 }, { 0, -4 }, { 0, -5 }, { 0, -6 }, { -1, -6 } } ),
+	} };
+};
+
+struct BenchSettings
+{
+	filesystem::path levelsDirectory = "build";
+	filesystem::path output;
+	int maxSize = 8192;
+	// A single search over 1024x1024 cells already takes seconds, so pathfinder benchmarks stop at a smaller size by default
+	int maxPathfinderSize = 1024;
+	double minSeconds = 0.2;
+	uint64_t seed = 1;
+};
+
+class Bench
+{
+public:
+	Bench( const BenchSettings& _settings ) : settings( _settings ) { }
+
+	// Times the function until it ran for the minimum time, at least once
+	void run( const string& name, const string& levelName, const Vector2Int& size, const function<void()>& function )
+	{
+		vector<double> times;
+		double total = 0;
+		while ( times.empty() || total < settings.minSeconds )
+		{
+			const auto start = chrono::steady_clock::now();
+			function();
+			const double nanoseconds = chrono::duration<double, nano>( chrono::steady_clock::now() - start ).count();
+			times.push_back( nanoseconds );
+			total += nanoseconds / 1e9;
+		}
+
+		sort( times.begin(), times.end() );
+		nlohmann::json result;
+		result[ "name" ] = name;
+		result[ "level" ] = levelName;
+		result[ "width" ] = size.x;
+		result[ "height" ] = size.y;
+		result[ "iterations" ] = times.size();
+		result[ "minNs" ] = times.front();
+		result[ "medianNs" ] = times.at( times.size() / 2 );
+		result[ "meanNs" ] = total * 1e9 / times.size();
+		results.push_back( result );
+
+		cerr << name << " " << levelName << " " << size.x << "x" << size.y << ": " << times.at( times.size() / 2 ) / 1e3 << " us" << endl;
+	}
+
+	nlohmann::json getResults() const
+	{
+		return nlohmann::json{ { "benchmarks", results } };
+	}
+
+private:
+	const BenchSettings& settings;
+	vector<nlohmann::json> results;
+};
+
+// Keeps the compiler from dropping a computation whose result is otherwise unused
+static void doNotOptimize( const int value )
+{
+	static volatile int sink;
+	sink = value;
+	( void )sink;
+}
+
+// Rows of floors with regular gaps to jump through, coins and enemies, scaled to any size
+static Level createSyntheticLevel( const Vector2Int& size, const uint64_t seed )
+{
+	mt19937_64 random( seed );
+	vector<int> cells( size.x * size.y, Tiles::getEmpty() );
+	auto cellAt = [ &cells, &size ]( const int x, const int y )->int& { return cells[ Vector2IntToIndex( Vector2Int{ x, y }, size.x ) ]; };
+
+	// Floors three rows apart, so that a high jump through a gap lands on the next one
+	for ( int i = size.y - 1; i >= 1; i -= 3 )
+	{
+		for ( int j = 0; j < size.x; ++j )
+		{
+			if ( i == size.y - 1 || ( j + i ) % 11 != 0 )
+			{
+				cellAt( j, i ) = 0;
+			}
+		}
+
+		for ( int j = 1; j < size.x - 13; ++j )
+		{
+			if ( cellAt( j, i ) == Tiles::getEmpty() )
+			{
+				continue;
+			}
+
+			const int roll = int( random() % 64 );
+			if ( roll < 4 )
+			{
+				cellAt( j, i - 1 ) = Tiles::getCoin();
+			} else if ( roll == 4 )
+			{
+				cellAt( j, i - 1 ) = 261 + int( random() % 4 );
+			}
+		}
+	}
+
+	cellAt( 0, size.y - 2 ) = Tiles::getHero();
+	cellAt( size.x - 1, size.y - 2 ) = Tiles::getClosedExit();
+
+	return Level( size, std::move( cells ) );
+}
+
+static void benchLevel( Bench& bench, const BenchSettings& settings, const string& levelName, const filesystem::path& path, const Level& level )
+{
+	const Vector2Int size = level.getSize();
+
+	bench.run( "level_parse", levelName, size, [ &path ]() { const Level parsed( path ); } );
+
+	// Enemies and the per frame checks of Session::step
+	vector<Enemy> enemies;
+	for ( int i = 0; i < size.y; ++i )
+	{
+		for ( int j = 0; j < size.x; ++j )
+		{
+			const int cell = level.getCellAt( Vector2Int{ j, i } );
+			if ( Tiles::isEnemyBlueprint( cell ) )
+			{
+				enemies.push_back( createEnemyFromBlueprint( Vector2Int{ j, i }, cell ) );
+			}
+		}
+	}
+	const Fixed enemyDistance = getDistancePerTick( 3.0f );
+	bench.run( "update_enemies", levelName, size, [ &enemies, &enemyDistance ]()
+		{
+			for ( Enemy& enemy : enemies )
+			{
+				updateEnemy( enemy, enemyDistance );
+			}
+		} );
+
+	mt19937_64 random( settings.seed );
+	vector<Vector2Fixed> heroPositions( 1000 );
+	for ( Vector2Fixed& position : heroPositions )
+	{
+		position = Vector2FixedFromInt( Vector2Int{ int( random() % size.x ), int( random() % size.y ) } );
+	}
+	const Fixed coinRadius = Fixed::fromFloat( 0.3f );
+	const Fixed enemyRadius = Fixed::fromFloat( 0.4f );
+	bench.run( "hero_contacts_x1000", levelName, size, [ &level, &heroPositions, &enemies, &coinRadius, &enemyRadius ]()
+		{
+			int touches = 0;
+			for ( const Vector2Fixed& position : heroPositions )
+			{
+				const HeroContacts contacts = findHeroContacts( level, position, enemies, coinRadius, enemyRadius );
+				touches += contacts.coin + contacts.enemy;
+			}
+			doNotOptimize( touches );
+		} );
+	bench.run( "exit_lookup", levelName, size, [ &level ]() { doNotOptimize( level.findFirstCell( Tiles::getClosedExit() ).x ); } );
+
+	if ( size.x > settings.maxPathfinderSize || size.y > settings.maxPathfinderSize )
+	{
+		return;
+	}
+
+	// Worst case: from the hero to the reachable cell farthest from it
+	Pathfinder pathfinder( level );
+	const Vector2Int hero = level.findFirstCell( Tiles::getHero() );
+	if ( hero.x == -1 )
+	{
+		return;
+	}
+	const vector<bool> reachable = pathfinder.findReachableCells( hero );
+	vector<Vector2Int> reachableCells;
+	Vector2Int farthest = hero;
+	for ( int i = 0; i < size.y; ++i )
+	{
+		for ( int j = 0; j < size.x; ++j )
+		{
+			if ( reachable[ Vector2IntToIndex( Vector2Int{ j, i }, size.x ) ] )
+			{
+				reachableCells.push_back( Vector2Int{ j, i } );
+				if ( abs( j - hero.x ) + abs( i - hero.y ) > abs( farthest.x - hero.x ) + abs( farthest.y - hero.y ) )
+				{
+					farthest = Vector2Int{ j, i };
+				}
+			}
+		}
+	}
+	bench.run( "pathfinder_worst", levelName, size, [ &pathfinder, &hero, &farthest ]() { pathfinder.goTo( hero, farthest ); } );
+	BasicPathfinder<DoubleJumpMoveSet> doubleJumpPathfinder( level );
+	bench.run( "pathfinder_worst_double_jump", levelName, size, [ &doubleJumpPathfinder, &hero, &farthest ]() { doubleJumpPathfinder.goTo( hero, farthest ); } );
+	bench.run( "flow_field", levelName, size, [ &pathfinder, &hero ]() { doNotOptimize( pathfinder.computeFlowField( hero ).moves.front() ); } );
+
+	// One tick of crowd mode, once its flow fields are cached; deferred jobs compute them during the first update
+	Crowd crowd( level, pathfinder, hero, 10000, 8, settings.seed, launch::deferred );
+	const Fixed crowdSteps = getDistancePerTick( 16 );
+	crowd.update( crowdSteps );
+	bench.run( "crowd_update_x10000", levelName, size, [ &crowd, &crowdSteps ]() { crowd.update( crowdSteps ); } );
+
+	bench.run( "pathfinder_random", levelName, size, [ &pathfinder, &hero, &reachableCells, &random ]()
+		{
+			const Vector2Int destination = reachableCells.at( random() % reachableCells.size() );
+			pathfinder.goTo( hero, destination );
+		} );
+
+	vector<Vector2Int> cellPath;
+	for ( const PathPoint& point : pathfinder.goTo( hero, farthest ) )
+	{
+		cellPath.push_back( Vector2FixedFloor( point.coords ) );
+	}
+	bench.run( "catmull_clark", levelName, size, [ &cellPath ]() { Pathfinder::catmullClark( cellPath, 2, 0, MoveFlags_None ); } );
+}
+
+static BenchSettings parseArguments( const int argc, char** argv )
+{
+	BenchSettings settings;
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		const string argument = argv[ i ];
+		if ( i + 1 >= argc )
+		{
+			throw BaseException( "Missing value for " + argument );
+		}
+		const string value = argv[ ++i ];
+
+		if ( argument == "--levels" )
+		{
+			settings.levelsDirectory = value;
+		} else if ( argument == "--output" )
+		{
+			settings.output = value;
+		} else if ( argument == "--max-size" )
+		{
+			settings.maxSize = stoi( value );
+		} else if ( argument == "--max-pathfinder-size" )
+		{
+			settings.maxPathfinderSize = stoi( value );
+		} else if ( argument == "--min-seconds" )
+		{
+			settings.minSeconds = stod( value );
+		} else if ( argument == "--seed" )
+		{
+			settings.seed = stoull( value );
+		} else
+		{
+			throw BaseException( "Unknown argument " + argument );
+		}
+	}
+
+	return settings;
+}
+
+int main( int argc, char** argv )
+{
+	try
+	{
+		const BenchSettings settings = parseArguments( argc, argv );
+		Bench bench( settings );
+
+		// Bundled levels
+		for ( int i = 0; ; ++i )
+		{
+			const filesystem::path path = settings.levelsDirectory / ( "level" + to_string( i ) + ".csv" );
+			if ( !filesystem::exists( path ) )
+			{
+				break;
+			}
+			const Level level( path );
+			benchLevel( bench, settings, path.filename().string(), path, level );
+		}
+
+		// Synthetic levels, from the bundled size up
+		const filesystem::path syntheticPath = filesystem::temp_directory_path() / "robodaniel_bench_level.csv";
+		for ( Vector2Int size{ 24, 15 }; size.x <= settings.maxSize && size.y <= settings.maxSize; )
+		{
+			const Level level = createSyntheticLevel( size, settings.seed );
+			level.save( syntheticPath );
+			benchLevel( bench, settings, "synthetic", syntheticPath, level );
+
+			if ( size.x == 24 )
+			{
+				size = Vector2Int{ 64, 64 };
+			} else
+			{
+				size = Vector2Int{ size.x * 2, size.y * 2 };
+			}
+		}
+		filesystem::remove( syntheticPath );
+
+		const string json = bench.getResults().dump( 1, '\t' );
+		if ( settings.output.empty() )
+		{
+			cout << json << endl;
+		} else
+		{
+			ofstream stream( settings.output );
+			stream << json << endl;
+		}
+
+		return 0;
+	}
+	catch ( const exception& e )
+	{
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+}
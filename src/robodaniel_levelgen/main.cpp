@@ -0,0 +1,336 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <raylib.h>
+#include <intmath.hpp>
+
+#include <level.hpp>
+#include <pathfinder.hpp>
+
+using namespace std;
+
+struct GeneratorSettings
+{
+	uint64_t seed = 0;
+	int count = 1000;
+	Vector2Int size{ 24, 15 };
+	int coins = 6;
+	int enemies = 3;
+	int threads = 0;
+	filesystem::path outputDirectory;
+};
+
+class LevelGenerator
+{
+public:
+	LevelGenerator( const GeneratorSettings& _settings ) : settings( _settings ) { }
+
+	// Returns a random level, not necessarily solvable
+	Level generate( const uint64_t seed ) const
+	{
+		mt19937_64 random( seed );
+		auto randomInt = [ &random ]( const int min, const int max ) { return uniform_int_distribution<int>( min, max )( random ); };
+
+		const Vector2Int& size = settings.size;
+		vector<int> cells( size.x * size.y, Tiles::getEmpty() );
+		auto cellAt = [ &cells, &size ]( const Vector2Int& position )->int& { return cells[ Vector2IntToIndex( position, size.x ) ]; };
+
+		// Walls and floor, with a few pits
+		for ( int i = 0; i < size.y; ++i )
+		{
+			cellAt( Vector2Int{ 0, i } ) = 0;
+			cellAt( Vector2Int{ size.x - 1, i } ) = 0;
+		}
+		for ( int j = 0; j < size.x; ++j )
+		{
+			cellAt( Vector2Int{ j, size.y - 1 } ) = 0;
+		}
+		const int pits = randomInt( 0, size.x / 8 );
+		for ( int i = 0; i < pits; ++i )
+		{
+			const int x = randomInt( 2, size.x - 4 );
+			const int width = randomInt( 1, 2 );
+			for ( int j = x; j < x + width; ++j )
+			{
+				cellAt( Vector2Int{ j, size.y - 1 } ) = Tiles::getEmpty();
+			}
+		}
+
+		// Floating platforms
+		const int platforms = ( size.x * size.y ) / 40;
+		for ( int i = 0; i < platforms; ++i )
+		{
+			const int length = randomInt( 2, 6 );
+			const int y = randomInt( 2, size.y - 3 );
+			const int x = randomInt( 1, std::max( 1, size.x - 1 - length ) );
+			for ( int j = x; j < std::min( x + length, size.x - 1 ); ++j )
+			{
+				cellAt( Vector2Int{ j, y } ) = 1;
+			}
+		}
+
+		// Cells where something can stand
+		vector<Vector2Int> standingCells;
+		for ( int i = 0; i < size.y - 1; ++i )
+		{
+			for ( int j = 1; j < size.x - 1; ++j )
+			{
+				const Vector2Int position{ j, i };
+				if ( cellAt( position ) == Tiles::getEmpty() && Tiles::isGround( cellAt( Vector2Int{ j, i + 1 } ) ) )
+				{
+					standingCells.push_back( position );
+				}
+			}
+		}
+		if ( standingCells.size() < 2 )
+		{
+			return Level( size, std::move( cells ) );
+		}
+
+		const Vector2Int hero = standingCells.at( randomInt( 0, standingCells.size() - 1 ) );
+
+		// Only place the exit and coins where the hero can get, leaving the full check to verify()
+		const Level terrain( size, cells );
+		const vector<bool> reachable = Pathfinder( terrain ).findReachableCells( hero );
+		cellAt( hero ) = Tiles::getHero();
+
+		vector<Vector2Int> candidates;
+		for ( const Vector2Int& position : standingCells )
+		{
+			if ( reachable[ Vector2IntToIndex( position, size.x ) ] && position != hero )
+			{
+				candidates.push_back( position );
+			}
+		}
+		if ( candidates.size() < settings.coins + 1 )
+		{
+			return Level( size, std::move( cells ) );
+		}
+		shuffle( candidates.begin(), candidates.end(), random );
+
+		auto it = candidates.begin();
+		cellAt( *it++ ) = Tiles::getClosedExit();
+
+		// Coins rest on the ground or float just above it
+		for ( int i = 0; i < settings.coins; ++i )
+		{
+			Vector2Int position = *it++;
+			const Vector2Int above{ position.x, position.y - 1 };
+			if ( above.y >= 0 && cellAt( above ) == Tiles::getEmpty() && reachable[ Vector2IntToIndex( above, size.x ) ] && randomInt( 0, 2 ) == 0 )
+			{
+				position = above;
+			}
+			cellAt( position ) = Tiles::getCoin();
+		}
+
+		// Enemies must not start on top of the hero
+		for ( int i = 0; i < settings.enemies; ++i )
+		{
+			const int blueprint = randomInt( 257, 272 );
+			const TileProperties properties = Tiles::getProperties( blueprint );
+			const int pathLength = properties.pathLength;
+			const bool horizontal = properties.flags & TileFlags_Horizontal;
+
+			const Vector2Int position{ randomInt( 1, size.x - 2 ), randomInt( 0, size.y - 2 ) };
+			const Vector2Int end = horizontal ? Vector2Int{ position.x + pathLength - 1, position.y } : Vector2Int{ position.x, position.y - ( pathLength - 1 ) };
+			if ( end.x >= size.x - 1 || end.y < 0 || cellAt( position ) != Tiles::getEmpty() )
+			{
+				continue;
+			}
+			if ( horizontal ? ( hero.y == position.y && hero.x >= position.x && hero.x <= end.x ) : ( hero.x == position.x && hero.y <= position.y && hero.y >= end.y ) )
+			{
+				continue;
+			}
+			cellAt( position ) = blueprint;
+		}
+
+		return Level( size, std::move( cells ) );
+	}
+
+	// Checks that the hero can collect every coin, getting back to the start each time, and then reach the exit
+	bool verify( const Level& level ) const
+	{
+		const Vector2Int hero = level.findFirstCell( Tiles::getHero() );
+		const Vector2Int exit = level.findFirstCell( Tiles::getClosedExit() );
+		if ( hero.x == -1 || exit.x == -1 )
+		{
+			return false;
+		}
+
+		const Pathfinder pathfinder( level );
+		auto cellIndex = [ width = level.getSize().x ]( const Vector2Int& position ) { return Vector2IntToIndex( position, width ); };
+
+		const vector<bool> reachableFromHero = pathfinder.findReachableCells( hero );
+		if ( !reachableFromHero[ cellIndex( exit ) ] )
+		{
+			return false;
+		}
+
+		unordered_map<CellKey, bool> heroReachableFromLanding;
+		for ( const Vector2Int& coin : level.findAllCells( Tiles::getCoin() ) )
+		{
+			if ( !reachableFromHero[ cellIndex( coin ) ] )
+			{
+				return false;
+			}
+
+			const Vector2Int landing = pathfinder.findLandingCell( coin );
+			if ( landing.y >= level.getSize().y )
+			{
+				return false;
+			}
+
+			const CellKey landingKey( landing );
+			if ( !heroReachableFromLanding.count( landingKey ) )
+			{
+				heroReachableFromLanding[ landingKey ] = landing == hero || pathfinder.findReachableCells( landing )[ cellIndex( hero ) ];
+			}
+			if ( !heroReachableFromLanding.at( landingKey ) )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	const GeneratorSettings& settings;
+};
+
+// Mixes the base seed with the level index and attempt, so that every level only depends on its own index
+static uint64_t getAttemptSeed( const uint64_t seed, const int levelIndex, const int attempt )
+{
+	uint64_t value = seed ^ ( uint64_t( levelIndex ) << 32 ) ^ uint64_t( attempt );
+	value += 0x9e3779b97f4a7c15ull;
+	value = ( value ^ ( value >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+	value = ( value ^ ( value >> 27 ) ) * 0x94d049bb133111ebull;
+	return value ^ ( value >> 31 );
+}
+
+static GeneratorSettings parseArguments( const int argc, char** argv )
+{
+	GeneratorSettings settings;
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		const string argument = argv[ i ];
+		if ( i + 1 >= argc )
+		{
+			throw BaseException( "Missing value for " + argument );
+		}
+		const string value = argv[ ++i ];
+
+		if ( argument == "--seed" )
+		{
+			settings.seed = stoull( value );
+		} else if ( argument == "--count" )
+		{
+			settings.count = stoi( value );
+		} else if ( argument == "--width" )
+		{
+			settings.size.x = stoi( value );
+		} else if ( argument == "--height" )
+		{
+			settings.size.y = stoi( value );
+		} else if ( argument == "--coins" )
+		{
+			settings.coins = stoi( value );
+		} else if ( argument == "--enemies" )
+		{
+			settings.enemies = stoi( value );
+		} else if ( argument == "--threads" )
+		{
+			settings.threads = stoi( value );
+		} else if ( argument == "--output" )
+		{
+			settings.outputDirectory = value;
+		} else
+		{
+			throw BaseException( "Unknown argument " + argument );
+		}
+	}
+
+	if ( settings.size.x < 8 || settings.size.y < 6 )
+	{
+		throw BaseException( "Levels must be at least 8x6" );
+	}
+
+	return settings;
+}
+
+int main( int argc, char** argv )
+{
+	try
+	{
+		const GeneratorSettings settings = parseArguments( argc, argv );
+		const LevelGenerator generator( settings );
+		const int maxAttempts = 1000;
+
+		if ( !settings.outputDirectory.empty() )
+		{
+			filesystem::create_directories( settings.outputDirectory );
+		}
+
+		atomic<int> nextLevelIndex = 0;
+		atomic<int> rejectedLevels = 0;
+		atomic<int> failedLevels = 0;
+
+		auto worker = [ & ]()
+		{
+			for ( int levelIndex = nextLevelIndex++; levelIndex < settings.count; levelIndex = nextLevelIndex++ )
+			{
+				int attempt = 0;
+				for ( ; attempt < maxAttempts; ++attempt )
+				{
+					const Level level = generator.generate( getAttemptSeed( settings.seed, levelIndex, attempt ) );
+					if ( generator.verify( level ) )
+					{
+						if ( !settings.outputDirectory.empty() )
+						{
+							level.save( settings.outputDirectory / ( "level" + to_string( levelIndex ) + ".csv" ) );
+						}
+						break;
+					}
+					++rejectedLevels;
+				}
+
+				if ( attempt == maxAttempts )
+				{
+					++failedLevels;
+				}
+			}
+		};
+
+		const int threadCount = settings.threads > 0 ? settings.threads : std::max( 1u, thread::hardware_concurrency() );
+		const auto startTime = chrono::steady_clock::now();
+		{
+			vector<thread> threads;
+			for ( int i = 0; i < threadCount; ++i )
+			{
+				threads.emplace_back( worker );
+			}
+			for ( thread& t : threads )
+			{
+				t.join();
+			}
+		}
+		const double seconds = chrono::duration<double>( chrono::steady_clock::now() - startTime ).count();
+
+		cout << "Generated " << ( settings.count - failedLevels ) << " levels (" << rejectedLevels << " rejected, " << failedLevels << " failed) in "
+			<< seconds << " s on " << threadCount << " threads, " << ( settings.count / seconds ) << " levels/s" << endl;
+
+		return failedLevels == 0 ? 0 : 1;
+	}
+	catch ( const exception& e )
+	{
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+}